@@ -13,7 +13,7 @@ BLEAddress CONTROL_BT_ADDR("40:f5:20:45:57:7e");
 bool tryConnecting = false;
 bool connected = false;
 
-bool sendingColors = false;
+volatile bool sendingColors = false;
 
 BLERemoteCharacteristic* pRemoteRxCharacteristic;
 BLERemoteCharacteristic* pRemoteTxCharacteristic;
@@ -117,7 +117,10 @@ void loop() {
   }
   else if (connected && sendingColors) {
     uint32_t colors[6];
-    seeColorsFromCamera(colors);
-    sendColors(colors);
+    if (seeColorsFromCamera(colors)) {
+      const unsigned long start = micros();
+      sendColors(colors);
+      recordSendTime(micros() - start);
+    }
   }
 }
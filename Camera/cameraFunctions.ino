@@ -1,33 +1,103 @@
-#include "fd_forward.h"
+#include "FS.h"
+#include "SPIFFS.h"
+#include "colorBoost.h"
+#include "img_converters.h"
+#include "regionMapFile.h"
 #include "regionMapping.h"
+#include "regionStats.h"
 
-dl_matrix3du_t* image_matrix;
+#include "freertos/queue.h"
 
-esp_err_t capture_handler(uint8_t** out_buf) {
+// Print how long each stage of a frame takes, on average, every
+// timingFrames frames. Turn on when benchmarking.
+const bool printTiming = false;
+const int timingFrames = 100;
+
+// A map made by host/regionMapTool.py here replaces the regions compiled
+// in from regionMapping.h, so the camera can be recalibrated without
+// recompiling
+const char* regionMapPath = "/regions.rmap";
+const uint16_t frameWidth = 320;
+const uint16_t frameHeight = 240;
+
+RegionStats regionStats;
+const ColorBoost colorBoost;
+uint8_t* rgbBuf = NULL;
+size_t rgbBufSize = 0;
+
+// Colors of one frame and how long the camera's side of it took. The
+// capture task fills one slot while loop() sends the other.
+struct FrameSlot {
+  uint32_t colors[6];
+  unsigned long captureMicros;
+  unsigned long totalsMicros;
+  unsigned long colorsMicros;
+};
+
+FrameSlot frameSlots[2];
+// Indexes into frameSlots, passed between the capture task and loop()
+QueueHandle_t freeSlots;
+QueueHandle_t readySlots;
+
+struct StageTiming {
+  unsigned long capture;
+  unsigned long totals;
+  unsigned long colors;
+  unsigned long send;
+  unsigned long lastFrame;
+  unsigned long frameTime;
+  int frames;
+};
+
+StageTiming timing;
+
+// Totals the regions of the next frame into regionStats, timing it in
+// frameSlots[index]
+esp_err_t capture_handler(uint8_t index) {
+    FrameSlot& slot = frameSlots[index];
+    unsigned long start = micros();
     camera_fb_t* fb = esp_camera_fb_get();
+    slot.captureMicros = micros() - start;
 
     if (!fb) {
       // Serial.println("Camera capture failed");
       return ESP_FAIL;
     }
 
-    image_matrix = dl_matrix3du_alloc(1, fb->width, fb->height, 3);
-    if (!image_matrix) {
+    start = micros();
+    const uint32_t pixelCount = fb->width * fb->height;
+
+    // RGB565 frames are read where the camera left them, with nothing to
+    // decode or allocate
+    if (fb->format == PIXFORMAT_RGB565) {
+      regionStats.buildRGB565(fb->buf, pixelCount);
       esp_camera_fb_return(fb);
-      // Serial.println("dl_matrix3du_alloc failed");
-      return ESP_FAIL;
+      slot.totalsMicros = micros() - start;
+      return ESP_OK;
     }
 
-    *out_buf = image_matrix->item;
+    // Anything else is converted into the same buffer every frame, which
+    // only grows if the frames do
+    if (pixelCount * 3 > rgbBufSize) {
+      free(rgbBuf);
+      rgbBuf = (uint8_t*)ps_malloc(pixelCount * 3);
+      rgbBufSize = rgbBuf ? pixelCount * 3 : 0;
+    }
+    if (!rgbBuf) {
+      esp_camera_fb_return(fb);
+      // Serial.println("rgb888 buffer alloc failed");
+      return ESP_FAIL;
+    }
 
-    bool s = fmt2rgb888(fb->buf, fb->len, fb->format, *out_buf);
+    bool s = fmt2rgb888(fb->buf, fb->len, fb->format, rgbBuf);
     esp_camera_fb_return(fb);
     if(!s){
-      dl_matrix3du_free(image_matrix);
       // Serial.println("to rgb888 failed");
       return ESP_FAIL;
     }
 
+    regionStats.build(rgbBuf, pixelCount);
+    slot.totalsMicros = micros() - start;
     return ESP_OK;
 }
 
@@ -52,12 +122,21 @@ void cameraStart() {
   config.pin_pwdn = 32;
   config.pin_reset = -1;
   config.xclk_freq_hz = 20000000;
-  config.pixel_format = PIXFORMAT_JPEG;
-  config.frame_size = FRAMESIZE_UXGA;
+  // Raw frames at the size the regions were mapped at, so they can be
+  // sampled without decoding
+  config.pixel_format = PIXFORMAT_RGB565;
+  config.frame_size = FRAMESIZE_QVGA;
   config.jpeg_quality = 10;
   config.fb_count = 2;
   
-  if (esp_camera_init(&config) != ESP_OK) {
+  const bool cameraReady = esp_camera_init(&config) == ESP_OK;
+
+  // Started either way, so without a camera each capture fails and sending
+  // stops rather than loop() waiting on queues that were never made
+  regionStatsStart();
+  pipelineStart();
+
+  if (!cameraReady) {
     // Serial.printf("Camera init failed with error");
     return;
   }
@@ -82,110 +161,135 @@ void cameraStart() {
   s->set_contrast(s, 0);
 }
 
-uint32_t increaseColor(uint8_t r, uint8_t g, uint8_t b) {
-  r = std::max(0, r - 60);
-  r = std::sqrt(r / 255.0) * 255;
-  g = std::sqrt(g / 255.0) * 255;
-  b = std::sqrt(b / 255.0) * 255;
-  
-  const int cMax = r > g ? (r > b ? r : b) : (g > b ? g : b);
-  const int cMin = r < g ? (r < b ? r : b) : (g < b ? g : b);
-  const float chr = cMax - cMin;
-  const float v = std::min(255.0, cMax * 1.75);
-  float h = 0;
-
-  if (v > 0) {
-    if (chr > 0) {
-      if (r == cMax) {
-        h = (g - b) / chr;
-        if (h < 0) h += 6;
-      } 
-      else if (g == cMax) {
-        h = 2 + (b - r ) / chr;
-      }
-      else if (b == cMax) {
-        h = 4 + (r - g) / chr;
+bool loadRegionMap() {
+  if (!SPIFFS.begin()) return false;
+
+  File file = SPIFFS.open(regionMapPath, "r");
+  if (!file) return false;
+
+  // Read as it's decoded, without holding the whole file
+  RegionMapFile map;
+  const bool loaded = map.read([&file]() { return file.read(); });
+  file.close();
+
+  if (!loaded || map.regionCount() != 6 || map.frameWidth() != frameWidth ||
+      map.frameHeight() != frameHeight) {
+    Serial.println("Region map in flash doesn't fit, using built in regions");
+    return false;
+  }
+
+  regionStats.begin(map);
+  return true;
+}
+
+void regionStatsStart() {
+  if (loadRegionMap()) return;
+
+  // In the order colors are sent
+  const pixelRanges* const regions[6] = {
+    map_RT, map_MT, map_LT, map_LB, map_MB, map_RB
+  };
+  const int lengths[6] = {
+    sizeof(map_RT) / sizeof(pixelRanges),
+    sizeof(map_MT) / sizeof(pixelRanges),
+    sizeof(map_LT) / sizeof(pixelRanges),
+    sizeof(map_LB) / sizeof(pixelRanges),
+    sizeof(map_MB) / sizeof(pixelRanges),
+    sizeof(map_RB) / sizeof(pixelRanges)
+  };
+
+  regionStats.begin(regions, lengths, 6);
+}
+
+void captureFrames(void* parameters) {
+  for (;;) {
+    if (!sendingColors) {
+      // Frames still waiting are old by the time sending starts again, so
+      // their slots are freed rather than sent
+      uint8_t staleIndex;
+      while (xQueueReceive(readySlots, &staleIndex, 0)) {
+        xQueueSend(freeSlots, &staleIndex, 0);
       }
+
+      vTaskDelay(pdMS_TO_TICKS(20));
+      continue;
+    }
+
+    uint8_t index;
+    xQueueReceive(freeSlots, &index, portMAX_DELAY);
+    FrameSlot& slot = frameSlots[index];
+
+    // Every region's pixels are totalled in one pass, then each region is
+    // a lookup per run
+    if (ESP_OK != capture_handler(index)) {
+      sendingColors = false;
+      xQueueSend(freeSlots, &index, portMAX_DELAY);
+      continue;
     }
+
+    const unsigned long start = micros();
+    for (int i = 0; i < 6; i++) {
+      slot.colors[i] = regionStats.avgColor(i);
+    }
+    colorBoost.boost(slot.colors, 6);
+    slot.colorsMicros = micros() - start;
+
+    xQueueSend(readySlots, &index, portMAX_DELAY);
   }
+}
 
-  const int i = h;
-  const float f = h - i; 
-  const float q = v * (1 - f);
-  const float t = v * f;
-  switch (i) {
-    case 0: r = v; g = t; b = 0; break;
-    case 1: r = q; g = v; b = 0; break;
-    case 2: r = 0; g = v; b = t; break;
-    case 3: r = 0; g = q; b = v; break;
-    case 4: r = t; g = 0; b = v; break;
-    default: r = v; g = 0; b = q;
+// Frames are captured on the other core, so the next frame is being
+// captured and totalled while loop() sends the last one
+void pipelineStart() {
+  freeSlots = xQueueCreate(2, sizeof(uint8_t));
+  readySlots = xQueueCreate(2, sizeof(uint8_t));
+  for (uint8_t i = 0; i < 2; i++) {
+    xQueueSend(freeSlots, &i, 0);
   }
 
-  return (r << 16) | (g << 8) | b;
+  xTaskCreatePinnedToCore(captureFrames, "captureFrames", 4096, NULL, 1, NULL,
+    0);
 }
 
-uint32_t avgColorInRange(const std::pair<uint32_t, uint32_t> ranges[], int length, uint8_t* cameraBuf) {
-  int r = 0, g = 0, b = 0, total = 0;
-  for (int i = 0; i < length; i++) {
-    pixelRanges range = ranges[i];
-    for (int p = range.first; p <= range.second; p++) {
-      int location = p * 3;
-      r += cameraBuf[location] & 0xff;
-      g += cameraBuf[location + 1] & 0xff;
-      b += cameraBuf[location + 2] & 0xff;
-      total++;
-    }
+// Takes the colors of the next frame, false if none came in time
+bool seeColorsFromCamera(uint32_t* colors) {
+  uint8_t index;
+  if (!xQueueReceive(readySlots, &index, pdMS_TO_TICKS(100))) {
+    return false;
   }
 
-  r /= total;
-  g /= total;
-  b /= total;
+  const FrameSlot& slot = frameSlots[index];
+  for (int i = 0; i < 6; i++) {
+    colors[i] = slot.colors[i];
+  }
+  timing.capture += slot.captureMicros;
+  timing.totals += slot.totalsMicros;
+  timing.colors += slot.colorsMicros;
 
-  return increaseColor(r, g, b);
+  xQueueSend(freeSlots, &index, portMAX_DELAY);
+  return true;
 }
 
-void seeColorsFromCamera(uint32_t* colors) {
-  uint8_t* cameraBuf = NULL;
-  if (ESP_OK != capture_handler(&cameraBuf)) {
-    sendingColors = false;
-    return;
+void recordSendTime(unsigned long sendMicros) {
+  const unsigned long now = micros();
+  if (timing.lastFrame) {
+    timing.frameTime += now - timing.lastFrame;
   }
+  timing.lastFrame = now;
+  timing.send += sendMicros;
 
-  for (int i = 0; i < 6; i++) {
-    int length = 0;
-    const pixelRanges* ranges = NULL;
-
-    switch (i) {
-      case 2:
-        length = sizeof(map_LT);
-        ranges = map_LT;
-        break;
-      case 1:
-        length = sizeof(map_MT);
-        ranges = map_MT;
-        break;
-      case 0:
-        length = sizeof(map_RT);
-        ranges = map_RT;
-        break;
-      case 5:
-        length = sizeof(map_RB);
-        ranges = map_RB;
-        break;
-      case 4:
-        length = sizeof(map_MB);
-        ranges = map_MB;
-        break;
-      case 3:
-        length = sizeof(map_LB);
-        ranges = map_LB;
-        break;
-    }
+  if (++timing.frames < timingFrames) return;
 
-    length /= sizeof(pixelRanges);
-    colors[i] = avgColorInRange(ranges, length, cameraBuf);
+  if (printTiming) {
+    Serial.printf(
+      "{\"frames\": %d, \"capture_us\": %lu, \"totals_us\": %lu, "
+      "\"colors_us\": %lu, \"send_us\": %lu, \"frame_us\": %lu}\n",
+      timing.frames, timing.capture / timing.frames,
+      timing.totals / timing.frames, timing.colors / timing.frames,
+      timing.send / timing.frames, timing.frameTime / timing.frames);
   }
 
-  dl_matrix3du_free(image_matrix);
+  const unsigned long lastFrame = timing.lastFrame;
+  timing = StageTiming();
+  timing.lastFrame = lastFrame;
 }
@@ -0,0 +1,81 @@
+#ifndef COLOR_BOOST_H
+#define COLOR_BOOST_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+/*
+  The camera's color boost in integers. Each channel is square rooted,
+  red after taking 60 off it, and the color is then pushed to full
+  saturation at 1.75 times its value. Square roots and divisions come
+  from tables built once, so a color is a few lookups, multiplies and
+  shifts. Results are within 1 per channel of the floating point version.
+
+  Colors are 0xRRGGBB.
+*/
+class ColorBoost {
+ private:
+  uint8_t redRoot[256];
+  uint8_t root[256];
+  // 65536 / n rounded up, so dividing by n is a multiply and a shift
+  uint32_t reciprocal[256];
+
+ public:
+  ColorBoost() {
+    for (int i = 0; i < 256; i++) {
+      root[i] = sqrt(i / 255.0) * 255;
+      redRoot[i] = sqrt(std::max(0, i - 60) / 255.0) * 255;
+      reciprocal[i] = i ? (65536 + i - 1) / i : 0;
+    }
+  }
+
+  uint32_t boost(uint32_t color) const {
+    const int r = redRoot[(color >> 16) & 0xFF];
+    const int g = root[(color >> 8) & 0xFF];
+    const int b = root[color & 0xFF];
+
+    const int cMax = std::max(r, std::max(g, b));
+    const int chroma = cMax - std::min(r, std::min(g, b));
+    const uint32_t v = std::min(255, (cMax * 7) >> 2);
+    // Grays have no hue and come out red, as they always have
+    if (!chroma) return v << 16;
+
+    // Which sixth of the color wheel the hue is in, and how far into it
+    // in units of chroma
+    int sector, along;
+    if (r == cMax) {
+      sector = g >= b ? 0 : 5;
+      along = g >= b ? g - b : chroma + g - b;
+    }
+    else if (g == cMax) {
+      sector = b >= r ? 2 : 1;
+      along = b >= r ? b - r : chroma + b - r;
+    }
+    else {
+      sector = r >= g ? 4 : 3;
+      along = r >= g ? r - g : chroma + r - g;
+    }
+
+    const uint32_t rising = (v * along * reciprocal[chroma]) >> 16;
+    const uint32_t falling = (v * (chroma - along) * reciprocal[chroma]) >> 16;
+    switch (sector) {
+      case 0: return v << 16 | rising << 8;
+      case 1: return falling << 16 | v << 8;
+      case 2: return v << 8 | rising;
+      case 3: return falling << 8 | v;
+      case 4: return rising << 16 | v;
+      default: return v << 16 | falling;
+    }
+  }
+
+  void boost(uint32_t* colors, size_t count) const {
+    for (size_t i = 0; i < count; i++) {
+      colors[i] = boost(colors[i]);
+    }
+  }
+};
+
+#endif  // COLOR_BOOST_H
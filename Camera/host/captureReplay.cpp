@@ -0,0 +1,182 @@
+// Runs recorded camera frames through the region sampling used on the
+// camera, with esp_camera.h standing in for the driver:
+//
+//   g++ -O2 -std=c++11 -I. captureReplay.cpp -o captureReplay
+//   ./captureReplay [-m regions.rmap] [frame.rgb565 ...]
+//
+// Frames are raw 320x240 RGB565 dumps of fb->buf. Without any, a few
+// synthetic frames are used instead. Regions come from the map given
+// with -m, as the camera loads it from flash, or else regionMapping.h.
+//
+// Each frame is sampled straight from RGB565 and also the old way,
+// converted to RGB888 in a fresh buffer first, and the region colors are
+// compared. Results are printed as JSON:
+//
+//   direct_ns_per_frame     sampling the RGB565 frame where it is
+//   converted_ns_per_frame  converting to RGB888, then sampling
+//   matches                 whether every region color was the same
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "esp_camera.h"
+
+#include "../regionMapFile.h"
+#include "../regionMapping.h"
+#include "../regionStats.h"
+
+const int width = 320;
+const int height = 240;
+const int passes = 50;
+
+const pixelRanges* const regions[6] = {
+  map_RT, map_MT, map_LT, map_LB, map_MB, map_RB
+};
+const int lengths[6] = {
+  sizeof(map_RT) / sizeof(pixelRanges),
+  sizeof(map_MT) / sizeof(pixelRanges),
+  sizeof(map_LT) / sizeof(pixelRanges),
+  sizeof(map_LB) / sizeof(pixelRanges),
+  sizeof(map_MB) / sizeof(pixelRanges),
+  sizeof(map_RB) / sizeof(pixelRanges)
+};
+
+// What fmt2rgb888 does with an RGB565 frame, blue first
+void convertRGB565(const uint8_t* rgb565, size_t pixelCount, uint8_t* rgb) {
+  for (size_t i = 0; i < pixelCount; i++) {
+    const uint8_t high = *rgb565++;
+    const uint8_t low = *rgb565++;
+    *rgb++ = (low & 0x1F) << 3;
+    *rgb++ = (high & 0x07) << 5 | (low & 0xE0) >> 3;
+    *rgb++ = high & 0xF8;
+  }
+}
+
+std::vector<uint8_t> syntheticFrame(int seed) {
+  std::vector<uint8_t> frame(width * height * 2);
+  uint32_t noise = seed * 2654435761u;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      noise = noise * 1103515245 + 12345;
+      const uint16_t red = (x * 31 / width + seed) & 0x1F;
+      const uint16_t green = (y * 63 / height + (noise >> 28)) & 0x3F;
+      const uint16_t blue = (noise >> 16) & 0x1F;
+      const uint16_t value = red << 11 | green << 5 | blue;
+      frame[(y * width + x) * 2] = value >> 8;
+      frame[(y * width + x) * 2 + 1] = value;
+    }
+  }
+  return frame;
+}
+
+void sampleDirect(RegionStats& stats, uint32_t* colors) {
+  camera_fb_t* fb = esp_camera_fb_get();
+  stats.buildRGB565(fb->buf, fb->width * fb->height);
+  esp_camera_fb_return(fb);
+
+  for (int i = 0; i < 6; i++) {
+    colors[i] = stats.avgColor(i);
+  }
+}
+
+void sampleConverted(RegionStats& stats, uint32_t* colors) {
+  camera_fb_t* fb = esp_camera_fb_get();
+  const size_t pixelCount = fb->width * fb->height;
+  uint8_t* rgb = (uint8_t*)malloc(pixelCount * 3);
+  convertRGB565(fb->buf, pixelCount, rgb);
+  esp_camera_fb_return(fb);
+
+  stats.build(rgb, pixelCount);
+  free(rgb);
+
+  for (int i = 0; i < 6; i++) {
+    colors[i] = stats.avgColor(i);
+  }
+}
+
+bool loadRegionMap(const char* path, RegionStats& stats) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+
+  RegionMapFile map;
+  const bool loaded = map.read([file]() { return fgetc(file); });
+  fclose(file);
+  if (!loaded || map.regionCount() != 6 || map.frameWidth() != width ||
+      map.frameHeight() != height) {
+    return false;
+  }
+
+  stats.begin(map);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  RegionStats stats;
+  stats.begin(regions, lengths, 6);
+
+  int firstFrame = 1;
+  if (argc > 2 && std::string(argv[1]) == "-m") {
+    if (!loadRegionMap(argv[2], stats)) {
+      fprintf(stderr, "Couldn't load a %dx%d region map from %s\n", width,
+        height, argv[2]);
+      return 1;
+    }
+    firstFrame = 3;
+  }
+
+  hostCameraStart(width, height);
+  for (int i = firstFrame; i < argc; i++) {
+    if (!hostCameraLoad(argv[i])) {
+      fprintf(stderr, "Couldn't load a %dx%d RGB565 frame from %s\n", width,
+        height, argv[i]);
+      return 1;
+    }
+  }
+  const bool synthetic = firstFrame >= argc;
+  if (synthetic) {
+    for (int i = 0; i < 4; i++) {
+      hostCameraAdd(syntheticFrame(i));
+    }
+  }
+  const int frameCount = hostCamera().frames.size();
+
+  bool matches = true;
+  uint32_t direct[6];
+  uint32_t converted[6];
+  for (int frame = 0; frame < frameCount; frame++) {
+    hostCameraSeek(frame);
+    sampleDirect(stats, direct);
+    hostCameraSeek(frame);
+    sampleConverted(stats, converted);
+    for (int i = 0; i < 6; i++) {
+      matches = matches && direct[i] == converted[i];
+    }
+  }
+
+  const int sampledFrames = frameCount * passes;
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < sampledFrames; frame++) {
+    sampleDirect(stats, direct);
+  }
+  const double directNanos = std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / sampledFrames;
+
+  start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < sampledFrames; frame++) {
+    sampleConverted(stats, converted);
+  }
+  const double convertedNanos = std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / sampledFrames;
+
+  printf("{\"frames\": %d, \"synthetic\": %s, \"direct_ns_per_frame\": %.0f, "
+    "\"converted_ns_per_frame\": %.0f, \"matches\": %s}\n",
+    frameCount, synthetic ? "true" : "false", directNanos, convertedNanos,
+    matches ? "true" : "false");
+  return matches ? 0 : 1;
+}
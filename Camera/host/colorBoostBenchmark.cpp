@@ -0,0 +1,116 @@
+// Checks ColorBoost against the floating point increaseColor the camera
+// used before it, over every 24 bit color, and times both. Runs on a
+// computer rather than the camera:
+//
+//   g++ -O2 -std=c++11 colorBoostBenchmark.cpp -o colorBoostBenchmark
+//   ./colorBoostBenchmark
+//
+// Results are printed as JSON:
+//
+//   float_ns_per_color  the old increaseColor
+//   table_ns_per_color  ColorBoost::boost() over a batch of colors
+//   max_difference      largest difference in any channel of any color
+//   differing_colors    how many colors weren't exactly the same
+//
+// It fails if any channel is off by more than 1.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "../colorBoost.h"
+
+const uint32_t colorCount = 1 << 24;
+
+// increaseColor from cameraFunctions.ino before ColorBoost
+uint32_t floatIncreaseColor(uint8_t r, uint8_t g, uint8_t b) {
+  r = std::max(0, r - 60);
+  r = std::sqrt(r / 255.0) * 255;
+  g = std::sqrt(g / 255.0) * 255;
+  b = std::sqrt(b / 255.0) * 255;
+
+  const int cMax = r > g ? (r > b ? r : b) : (g > b ? g : b);
+  const int cMin = r < g ? (r < b ? r : b) : (g < b ? g : b);
+  const float chr = cMax - cMin;
+  const float v = std::min(255.0, cMax * 1.75);
+  float h = 0;
+
+  if (v > 0) {
+    if (chr > 0) {
+      if (r == cMax) {
+        h = (g - b) / chr;
+        if (h < 0) h += 6;
+      }
+      else if (g == cMax) {
+        h = 2 + (b - r ) / chr;
+      }
+      else if (b == cMax) {
+        h = 4 + (r - g) / chr;
+      }
+    }
+  }
+
+  const int i = h;
+  const float f = h - i;
+  const float q = v * (1 - f);
+  const float t = v * f;
+  switch (i) {
+    case 0: r = v; g = t; b = 0; break;
+    case 1: r = q; g = v; b = 0; break;
+    case 2: r = 0; g = v; b = t; break;
+    case 3: r = 0; g = q; b = v; break;
+    case 4: r = t; g = 0; b = v; break;
+    default: r = v; g = 0; b = q;
+  }
+
+  return (r << 16) | (g << 8) | b;
+}
+
+int channelDifference(uint32_t a, uint32_t b) {
+  int largest = 0;
+  for (int shift = 0; shift < 24; shift += 8) {
+    const int difference = abs((int)((a >> shift) & 0xFF) -
+      (int)((b >> shift) & 0xFF));
+    largest = std::max(largest, difference);
+  }
+  return largest;
+}
+
+int main() {
+  std::vector<uint32_t> reference(colorCount);
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t color = 0; color < colorCount; color++) {
+    reference[color] = floatIncreaseColor(color >> 16, color >> 8, color);
+  }
+  const double floatNanos = std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / colorCount;
+
+  std::vector<uint32_t> boosted(colorCount);
+  for (uint32_t color = 0; color < colorCount; color++) {
+    boosted[color] = color;
+  }
+  const ColorBoost colorBoost;
+  start = std::chrono::steady_clock::now();
+  colorBoost.boost(boosted.data(), colorCount);
+  const double tableNanos = std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / colorCount;
+
+  int maxDifference = 0;
+  uint32_t differing = 0;
+  for (uint32_t color = 0; color < colorCount; color++) {
+    const int difference = channelDifference(reference[color], boosted[color]);
+    maxDifference = std::max(maxDifference, difference);
+    differing += difference > 0;
+  }
+
+  printf("{\"colors\": %u, \"float_ns_per_color\": %.2f, "
+    "\"table_ns_per_color\": %.2f, \"max_difference\": %d, "
+    "\"differing_colors\": %u}\n",
+    colorCount, floatNanos, tableNanos, maxDifference, differing);
+  return maxDifference <= 1 ? 0 : 1;
+}
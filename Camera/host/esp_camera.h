@@ -0,0 +1,119 @@
+// Stand-in for the ESP32 camera driver so capture code can run on a
+// computer. esp_camera_fb_get() hands out recorded frames in turn, looping
+// back to the first, and each frame is used as the camera would give it.
+//
+// Recordings are raw RGB565 frames, two bytes a pixel high byte first,
+// which is fb->buf as it comes from the camera.
+
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+  PIXFORMAT_RGB565,
+  PIXFORMAT_YUV422,
+  PIXFORMAT_GRAYSCALE,
+  PIXFORMAT_JPEG,
+  PIXFORMAT_RGB888
+} pixformat_t;
+
+typedef struct {
+  uint8_t* buf;
+  size_t len;
+  size_t width;
+  size_t height;
+  pixformat_t format;
+} camera_fb_t;
+
+struct HostCamera {
+  size_t width;
+  size_t height;
+  std::vector<std::vector<uint8_t>> frames;
+  size_t nextFrame;
+  // Like config.fb_count, how many frames can be out at once
+  std::vector<camera_fb_t> buffers;
+  std::vector<bool> buffersOut;
+};
+
+inline HostCamera& hostCamera() {
+  static HostCamera camera;
+  return camera;
+}
+
+inline void hostCameraStart(size_t width, size_t height, int fbCount = 2) {
+  HostCamera& camera = hostCamera();
+  camera.width = width;
+  camera.height = height;
+  camera.frames.clear();
+  camera.nextFrame = 0;
+  camera.buffers.assign(fbCount, camera_fb_t());
+  camera.buffersOut.assign(fbCount, false);
+}
+
+inline bool hostCameraAdd(const std::vector<uint8_t>& frame) {
+  HostCamera& camera = hostCamera();
+  if (frame.size() != camera.width * camera.height * 2) return false;
+
+  camera.frames.push_back(frame);
+  return true;
+}
+
+inline bool hostCameraLoad(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return false;
+
+  std::vector<uint8_t> frame(hostCamera().width * hostCamera().height * 2);
+  const size_t read = fread(frame.data(), 1, frame.size(), file);
+  fclose(file);
+  return read == frame.size() && hostCameraAdd(frame);
+}
+
+// The frame the next esp_camera_fb_get() hands out
+inline void hostCameraSeek(size_t frame) {
+  HostCamera& camera = hostCamera();
+  camera.nextFrame = camera.frames.empty() ? 0 : frame % camera.frames.size();
+}
+
+inline camera_fb_t* esp_camera_fb_get() {
+  HostCamera& camera = hostCamera();
+  if (camera.frames.empty()) return NULL;
+
+  for (size_t i = 0; i < camera.buffers.size(); i++) {
+    if (camera.buffersOut[i]) continue;
+
+    std::vector<uint8_t>& frame = camera.frames[camera.nextFrame];
+    camera.nextFrame = (camera.nextFrame + 1) % camera.frames.size();
+
+    camera_fb_t& fb = camera.buffers[i];
+    fb.buf = frame.data();
+    fb.len = frame.size();
+    fb.width = camera.width;
+    fb.height = camera.height;
+    fb.format = PIXFORMAT_RGB565;
+    camera.buffersOut[i] = true;
+    return &fb;
+  }
+
+  // Every buffer is still out
+  return NULL;
+}
+
+inline void esp_camera_fb_return(camera_fb_t* fb) {
+  HostCamera& camera = hostCamera();
+  for (size_t i = 0; i < camera.buffers.size(); i++) {
+    if (fb == &camera.buffers[i]) {
+      camera.buffersOut[i] = false;
+    }
+  }
+}
+
+#endif  // HOST_ESP_CAMERA_H
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""Makes region maps for the camera, in the format RegionMapFile reads.
+
+Regions are polygons marked out on a reference image taken from where the
+camera sits. Each pixel whose center is inside a polygon belongs to that
+region. The corners are given as JSON, in the order colors are sent:
+
+  {"regions": [
+    {"name": "RT", "corners": [[12, 3], [60, 3], [36, 48]]},
+    ...
+  ]}
+
+  regionMapTool.py polygons corners.json -o regions.rmap --image ref.png
+  regionMapTool.py polygons corners.json -o regions.rmap --size 320x240
+  regionMapTool.py header ../regionMapping.h -o regions.rmap
+  regionMapTool.py dump regions.rmap
+
+--preview draws the regions over the reference image to check them, which
+needs Pillow, as does reading the size from --image. header converts the
+maps compiled into the camera so they can be loaded from flash as they
+are. Copy the map to the camera's SPIFFS as /regions.rmap.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"RMAP"
+VERSION = 1
+
+# The order the camera sends colors in
+HEADER_REGIONS = ["RT", "MT", "LT", "LB", "MB", "RB"]
+
+
+def write_varint(out, value):
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return
+
+
+def zigzag(value):
+    return value * 2 if value >= 0 else -value * 2 - 1
+
+
+def encode(width, height, regions):
+    """regions is a list of span lists, each span (row, column, length)."""
+    out = bytearray(MAGIC)
+    out += struct.pack("<BBHH", VERSION, len(regions), width, height)
+    for spans in regions:
+        write_varint(out, len(spans))
+        row = column = 0
+        for span_row, span_column, length in spans:
+            write_varint(out, span_row - row)
+            write_varint(out, zigzag(span_column - column))
+            write_varint(out, length - 1)
+            row, column = span_row, span_column
+    return bytes(out)
+
+
+def read_varint(data, offset):
+    value = shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, offset
+
+
+def decode(data):
+    if data[:4] != MAGIC or data[4] != VERSION:
+        raise ValueError("not a version %d region map" % VERSION)
+    region_count = data[5]
+    width, height = struct.unpack_from("<HH", data, 6)
+    offset = 10
+    regions = []
+    for _ in range(region_count):
+        span_count, offset = read_varint(data, offset)
+        spans = []
+        row = column = 0
+        for _ in range(span_count):
+            row_step, offset = read_varint(data, offset)
+            column_step, offset = read_varint(data, offset)
+            length, offset = read_varint(data, offset)
+            row += row_step
+            column += (column_step >> 1) ^ -(column_step & 1)
+            spans.append((row, column, length + 1))
+        regions.append(spans)
+    return width, height, regions
+
+
+def rasterize(corners, width, height):
+    """Spans of pixels whose centers are inside the polygon, by row."""
+    spans = []
+    edges = list(zip(corners, corners[1:] + corners[:1]))
+    for row in range(height):
+        y = row + 0.5
+        crossings = []
+        for (x0, y0), (x1, y1) in edges:
+            if (y0 <= y) != (y1 <= y):
+                crossings.append(x0 + (y - y0) * (x1 - x0) / (y1 - y0))
+        crossings.sort()
+        for left, right in zip(crossings[::2], crossings[1::2]):
+            first = max(0, int(-(-(left - 0.5) // 1)))
+            last = min(width - 1, int((right - 0.5) // 1))
+            if first <= last:
+                spans.append((row, first, last - first + 1))
+    return spans
+
+
+def spans_from_runs(runs, width):
+    """Splits inclusive (first, last) pixel runs into row spans."""
+    spans = []
+    for first, last in runs:
+        while first <= last:
+            row, column = divmod(first, width)
+            row_last = min(last, (row + 1) * width - 1)
+            spans.append((row, column, row_last - first + 1))
+            first = row_last + 1
+    return spans
+
+
+def image_size(path):
+    from PIL import Image
+
+    with Image.open(path) as image:
+        return image.size
+
+
+def draw_preview(image_path, size, regions, path):
+    from PIL import Image
+
+    colors = [(255, 0, 0), (0, 255, 0), (0, 0, 255), (255, 255, 0),
+              (255, 0, 255), (0, 255, 255)]
+    if image_path:
+        image = Image.open(image_path).convert("RGB")
+    else:
+        image = Image.new("RGB", size)
+    pixels = image.load()
+    for index, spans in enumerate(regions):
+        tint = colors[index % len(colors)]
+        for row, column, length in spans:
+            for x in range(column, column + length):
+                pixels[x, row] = tuple(
+                    (a + b) // 2 for a, b in zip(pixels[x, row], tint))
+    image.save(path)
+
+
+def parse_size(text):
+    width, height = text.lower().split("x")
+    return int(width), int(height)
+
+
+def polygons_command(args):
+    if args.image:
+        width, height = image_size(args.image)
+    elif args.size:
+        width, height = parse_size(args.size)
+    else:
+        sys.exit("Give the reference --image or the frame --size")
+
+    with open(args.corners) as file:
+        corners = json.load(file)["regions"]
+    regions = [rasterize([tuple(c) for c in region["corners"]], width, height)
+               for region in corners]
+    for region, spans in zip(corners, regions):
+        if not spans:
+            sys.exit("Region %s covers no pixels" % region.get("name", "?"))
+
+    write_map(args.output, width, height, regions)
+    if args.preview:
+        draw_preview(args.image, (width, height), regions, args.preview)
+
+
+def header_command(args):
+    with open(args.header) as file:
+        text = file.read()
+    width, height = parse_size(args.size)
+
+    regions = []
+    for name in HEADER_REGIONS:
+        match = re.search(r"map_%s\[\d*\]\s*=\s*\{(.*?)\};" % name, text, re.S)
+        if not match:
+            sys.exit("No map_%s in %s" % (name, args.header))
+        runs = [(int(a, 16), int(b, 16)) for a, b in
+                re.findall(r"\{\s*0x(\w+),\s*0x(\w+)\s*\}", match.group(1))]
+        regions.append(spans_from_runs(runs, width))
+
+    write_map(args.output, width, height, regions)
+
+
+def write_map(path, width, height, regions):
+    data = encode(width, height, regions)
+    if decode(data) != (width, height, regions):
+        sys.exit("Map didn't decode back to the same regions")
+    with open(path, "wb") as file:
+        file.write(data)
+    describe(data)
+
+
+def describe(data):
+    width, height, regions = decode(data)
+    spans = sum(len(region) for region in regions)
+    pixels = sum(length for region in regions for _, _, length in region)
+    print(json.dumps({
+        "width": width, "height": height, "regions": len(regions),
+        "spans": spans, "pixels": pixels, "bytes": len(data),
+        # What the same spans take as {first, last} uint32 pairs
+        "uint32_pair_bytes": spans * 8}))
+
+
+def dump_command(args):
+    with open(args.map, "rb") as file:
+        describe(file.read())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    polygons = commands.add_parser("polygons", help="map from polygon corners")
+    polygons.add_argument("corners")
+    polygons.add_argument("-o", "--output", required=True)
+    polygons.add_argument("--image", help="reference image from the camera")
+    polygons.add_argument("--size", help="frame size, like 320x240")
+    polygons.add_argument("--preview", help="where to save a preview image")
+    polygons.set_defaults(run=polygons_command)
+
+    header = commands.add_parser("header", help="map from regionMapping.h")
+    header.add_argument("header")
+    header.add_argument("-o", "--output", required=True)
+    header.add_argument("--size", default="320x240")
+    header.set_defaults(run=header_command)
+
+    dump = commands.add_parser("dump", help="describe a map")
+    dump.add_argument("map")
+    dump.set_defaults(run=dump_command)
+
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
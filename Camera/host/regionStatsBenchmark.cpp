@@ -0,0 +1,132 @@
+// Compares region averaging with RegionStats against walking every pixel
+// of every run, on a synthetic 320x240 RGB888 frame. Runs on a computer
+// rather than the camera:
+//
+//   g++ -O2 -std=c++11 regionStatsBenchmark.cpp -o regionStatsBenchmark
+//   ./regionStatsBenchmark
+//
+// The panels are the six regions in regionMapping.h. Halves adds the top
+// and bottom half of each panel on top of them, as matching more finely
+// than a panel at a time would. Results are printed as JSON:
+//
+//   walk_ns_per_frame    average time to average every region by walking
+//   totals_ns_per_frame  the same with RegionStats, including build()
+//   matches              whether both give the same colors
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "../regionMapping.h"
+#include "../regionStats.h"
+
+const int width = 320;
+const int height = 240;
+const int frameCount = 200;
+
+const pixelRanges* const panelRegions[6] = {
+  map_LT, map_MT, map_RT, map_RB, map_MB, map_LB
+};
+const int panelLengths[6] = {
+  sizeof(map_LT) / sizeof(pixelRanges),
+  sizeof(map_MT) / sizeof(pixelRanges),
+  sizeof(map_RT) / sizeof(pixelRanges),
+  sizeof(map_RB) / sizeof(pixelRanges),
+  sizeof(map_MB) / sizeof(pixelRanges),
+  sizeof(map_LB) / sizeof(pixelRanges)
+};
+
+// The loop cameraFunctions used before RegionStats
+uint32_t walkedAvgColor(
+  const pixelRanges ranges[], int length, const uint8_t* cameraBuf) {
+  int r = 0, g = 0, b = 0, total = 0;
+  for (int i = 0; i < length; i++) {
+    pixelRanges range = ranges[i];
+    for (uint32_t p = range.first; p <= range.second; p++) {
+      int location = p * 3;
+      r += cameraBuf[location] & 0xff;
+      g += cameraBuf[location + 1] & 0xff;
+      b += cameraBuf[location + 2] & 0xff;
+      total++;
+    }
+  }
+
+  return ((r / total) << 16) | ((g / total) << 8) | (b / total);
+}
+
+template <class Function>
+double timeFrames(Function fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frameCount; frame++) {
+    fn();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+    frameCount;
+}
+
+bool firstResult = true;
+bool allMatch = true;
+
+void benchmark(const char* name, const std::vector<const pixelRanges*>& regions,
+  const std::vector<int>& lengths, const std::vector<uint8_t>& frame) {
+  const int regionCount = regions.size();
+  std::vector<uint32_t> walked(regionCount);
+  std::vector<uint32_t> summed(regionCount);
+
+  const double walkNanos = timeFrames([&]() {
+    for (int i = 0; i < regionCount; i++) {
+      walked[i] = walkedAvgColor(regions[i], lengths[i], frame.data());
+    }
+  });
+
+  RegionStats stats;
+  stats.begin(regions.data(), lengths.data(), regionCount);
+  const double totalsNanos = timeFrames([&]() {
+    stats.build(frame.data(), width * height);
+    for (int i = 0; i < regionCount; i++) {
+      summed[i] = stats.avgColor(i);
+    }
+  });
+
+  const bool matches = walked == summed;
+  allMatch = allMatch && matches;
+
+  printf(firstResult ? "\n    " : ",\n    ");
+  firstResult = false;
+  printf("{\"regions\": \"%s\", \"count\": %d, \"walk_ns_per_frame\": %.0f, "
+    "\"totals_ns_per_frame\": %.0f, \"matches\": %s}",
+    name, regionCount, walkNanos, totalsNanos, matches ? "true" : "false");
+}
+
+int main() {
+  std::vector<uint8_t> frame(width * height * 3);
+  uint32_t seed = 12345;
+  for (uint8_t& level : frame) {
+    seed = seed * 1103515245 + 12345;
+    level = seed >> 24;
+  }
+
+  std::vector<const pixelRanges*> regions(panelRegions, panelRegions + 6);
+  std::vector<int> lengths(panelLengths, panelLengths + 6);
+
+  printf("{\"width\": %d, \"height\": %d, \"frames\": %d, \"results\": [",
+    width, height, frameCount);
+
+  benchmark("panels", regions, lengths, frame);
+
+  for (int i = 0; i < 6; i++) {
+    const int half = panelLengths[i] / 2;
+    regions.push_back(panelRegions[i]);
+    lengths.push_back(half);
+    regions.push_back(panelRegions[i] + half);
+    lengths.push_back(panelLengths[i] - half);
+  }
+  benchmark("halves", regions, lengths, frame);
+
+  printf("\n  ]}\n");
+  return allMatch ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#ifndef REGION_MAP_FILE_H
+#define REGION_MAP_FILE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+  Region maps made by host/regionMapTool.py, read a byte at a time so they
+  can come straight from a SPIFFS file or a memory mapped partition.
+
+  A map starts with "RMAP", a version byte, a region count byte and the
+  frame width and height as little endian 16 bit values. Each region is
+  then a span count followed by its spans, where a span is part of one
+  row. Spans are stored as differences from the one before, as LEB128
+  varints:
+
+    row - previous row
+    first column - previous first column, zigzag encoded
+    length - 1
+
+  so a span down the edge of a region usually takes three bytes.
+*/
+class RegionMapFile {
+ private:
+  static const uint8_t VERSION = 1;
+
+  uint16_t width;
+  uint16_t height;
+  // The spans of every region one after another, still encoded as they
+  // are in the file, so a map takes about as much memory as its file
+  std::vector<uint8_t> spans;
+  // Where each region's spans start in spans, and how many it has
+  std::vector<uint32_t> regionOffsets;
+  std::vector<uint32_t> spanCounts;
+
+  template <class ReadByte>
+  static bool readVarint(ReadByte& readByte, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+      const int byte = readByte();
+      if (byte < 0) return false;
+
+      value |= (uint32_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  template <class ReadByte>
+  static bool readUint16(ReadByte& readByte, uint16_t& value) {
+    const int low = readByte();
+    const int high = readByte();
+    if (low < 0 || high < 0) return false;
+
+    value = low | (high << 8);
+    return true;
+  }
+
+  // Reads the span after the one at row and column, moving them on to it,
+  // as inclusive pixel indexes
+  template <class ReadByte>
+  bool readSpan(ReadByte& readByte, uint32_t& row, int32_t& column,
+    uint32_t& first, uint32_t& last) const {
+    uint32_t rowStep, columnStep, length;
+    if (!readVarint(readByte, rowStep) || !readVarint(readByte, columnStep) ||
+        !readVarint(readByte, length)) {
+      return false;
+    }
+
+    row += rowStep;
+    column += (columnStep >> 1) ^ -(int32_t)(columnStep & 1);
+    length++;
+    if (row >= height || column < 0 || column + length > width) {
+      return false;
+    }
+
+    first = row * width + column;
+    last = first + length - 1;
+    return true;
+  }
+
+  template <class ReadByte>
+  bool readMap(ReadByte& readByte) {
+    const char magic[4] = {'R', 'M', 'A', 'P'};
+    for (int i = 0; i < 4; i++) {
+      if (readByte() != magic[i]) return false;
+    }
+    if (readByte() != VERSION) return false;
+
+    const int regionCount = readByte();
+    if (regionCount < 0) return false;
+    if (!readUint16(readByte, width) || !readUint16(readByte, height)) {
+      return false;
+    }
+
+    // Spans are checked as they're read and kept as the bytes they came in
+    auto keepByte = [this, &readByte]() {
+      const int byte = readByte();
+      if (byte >= 0) spans.push_back(byte);
+      return byte;
+    };
+
+    for (int region = 0; region < regionCount; region++) {
+      uint32_t spanCount;
+      if (!readVarint(readByte, spanCount)) return false;
+
+      regionOffsets.push_back(spans.size());
+      spanCounts.push_back(spanCount);
+      uint32_t row = 0;
+      int32_t column = 0;
+      for (uint32_t i = 0; i < spanCount; i++) {
+        uint32_t first, last;
+        if (!readSpan(keepByte, row, column, first, last)) return false;
+      }
+    }
+
+    spans.shrink_to_fit();
+    return true;
+  }
+
+  void clear() {
+    width = 0;
+    height = 0;
+    spans.clear();
+    regionOffsets.clear();
+    spanCounts.clear();
+  }
+
+ public:
+  RegionMapFile() : width(0), height(0) {}
+
+  // readByte returns the next byte of the map, or -1 at the end. Any map
+  // that doesn't fit its own frame size is rejected and leaves no regions.
+  template <class ReadByte>
+  bool read(ReadByte readByte) {
+    clear();
+    if (readMap(readByte)) return true;
+
+    clear();
+    return false;
+  }
+
+  uint16_t frameWidth() const { return width; }
+  uint16_t frameHeight() const { return height; }
+  int regionCount() const { return spanCounts.size(); }
+
+  // Calls run(first, last) with the inclusive pixel indexes of each of a
+  // region's spans, decoding them as it goes. RegionStats::begin() takes
+  // the map this way.
+  template <class Run>
+  void forEachRun(int region, Run run) const {
+    size_t next = regionOffsets[region];
+    auto nextByte = [this, &next]() { return (int)spans[next++]; };
+
+    uint32_t row = 0;
+    int32_t column = 0;
+    for (uint32_t i = 0; i < spanCounts[region]; i++) {
+      // Spans were checked when the map was read
+      uint32_t first = 0, last = 0;
+      readSpan(nextByte, row, column, first, last);
+      run(first, last);
+    }
+  }
+};
+
+#endif  // REGION_MAP_FILE_H
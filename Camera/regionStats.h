@@ -0,0 +1,163 @@
+#ifndef REGION_STATS_H
+#define REGION_STATS_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/*
+  Running color totals through an RGB888 frame, kept only at the pixels
+  where a region's run starts or ends. The total color of any run is then
+  the difference of two of them, so each region costs a lookup per run
+  and every pixel in the regions is read once a frame no matter how many
+  regions cover it. Pixels outside every region are skipped.
+
+  Regions are given once with begin(), then build() or buildRGB565()
+  takes each frame.
+*/
+class RegionStats {
+ private:
+  // Channels in the order their bytes sit in an RGB888 frame
+  struct ColorTotal {
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+  };
+
+  // Sorted pixel indexes where some run starts or ends, and the totals of
+  // every counted pixel before each of them
+  std::vector<uint32_t> cuts;
+  std::vector<ColorTotal> totals;
+  // Whether the pixels from each cut up to the next are in any run
+  std::vector<uint8_t> counted;
+
+  // Every run as the cuts at its first pixel and one past its last,
+  // grouped by region
+  std::vector<std::pair<uint16_t, uint16_t>> runCuts;
+  std::vector<uint16_t> regionStart;
+  std::vector<uint32_t> regionPixels;
+
+  uint16_t cutIndex(uint32_t pixel) const {
+    return std::lower_bound(cuts.begin(), cuts.end(), pixel) - cuts.begin();
+  }
+
+  // Regions kept as arrays of runs, like the ones in regionMapping.h
+  struct RegionArrays {
+    const std::pair<uint32_t, uint32_t>* const* regions;
+    const int* lengths;
+    int count;
+
+    int regionCount() const { return count; }
+
+    template <class Run>
+    void forEachRun(int region, Run run) const {
+      for (int i = 0; i < lengths[region]; i++) {
+        run(regions[region][i].first, regions[region][i].second);
+      }
+    }
+  };
+
+ public:
+  // Runs are inclusive {first, last} pixel indexes
+  void begin(const std::pair<uint32_t, uint32_t>* const regions[],
+    const int lengths[], int regionCount) {
+    begin(RegionArrays{regions, lengths, regionCount});
+  }
+
+  // Takes regions from anything with regionCount() and
+  // forEachRun(region, run), which calls run(first, last) for each of a
+  // region's runs in turn. Runs are gone through twice, so they don't
+  // need to be held anywhere else while the cuts are worked out.
+  template <class Regions>
+  void begin(const Regions& regions) {
+    const int regionCount = regions.regionCount();
+
+    cuts.clear();
+    for (int i = 0; i < regionCount; i++) {
+      regions.forEachRun(i, [this](uint32_t first, uint32_t last) {
+        cuts.push_back(first);
+        cuts.push_back(last + 1);
+      });
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    totals.assign(cuts.size(), ColorTotal{0, 0, 0});
+    counted.assign(cuts.size(), 0);
+    runCuts.clear();
+    regionStart.assign(1, 0);
+    regionPixels.clear();
+
+    for (int i = 0; i < regionCount; i++) {
+      uint32_t pixels = 0;
+      regions.forEachRun(i, [this, &pixels](uint32_t first, uint32_t last) {
+        const uint16_t firstCut = cutIndex(first);
+        const uint16_t endCut = cutIndex(last + 1);
+        std::fill(counted.begin() + firstCut, counted.begin() + endCut, 1);
+        runCuts.push_back(std::make_pair(firstCut, endCut));
+        pixels += last + 1 - first;
+      });
+      regionStart.push_back(runCuts.size());
+      regionPixels.push_back(pixels);
+    }
+  }
+
+  // Pixels past pixelCount count as black
+  void build(const uint8_t* rgb, uint32_t pixelCount) {
+    ColorTotal total = {0, 0, 0};
+    for (size_t i = 0; i < cuts.size(); i++) {
+      totals[i] = total;
+      if (!counted[i]) continue;
+
+      const uint8_t* pixel = rgb + std::min(cuts[i], pixelCount) * 3;
+      const uint8_t* end = rgb + std::min(cuts[i + 1], pixelCount) * 3;
+      for (; pixel < end; pixel += 3) {
+        total.r += pixel[0];
+        total.g += pixel[1];
+        total.b += pixel[2];
+      }
+    }
+  }
+
+  // Straight from the camera's RGB565 buffer, two bytes a pixel high byte
+  // first. Channels come out in the same order and scale as converting
+  // with fmt2rgb888 and calling build(), so averages are identical.
+  void buildRGB565(const uint8_t* rgb565, uint32_t pixelCount) {
+    // Fields are summed as they are and scaled to 8 bits when stored
+    uint32_t blue = 0, green = 0, red = 0;
+    for (size_t i = 0; i < cuts.size(); i++) {
+      totals[i] = ColorTotal{blue << 3, green << 2, red << 3};
+      if (!counted[i]) continue;
+
+      const uint8_t* pixel = rgb565 + std::min(cuts[i], pixelCount) * 2;
+      const uint8_t* end = rgb565 + std::min(cuts[i + 1], pixelCount) * 2;
+      for (; pixel < end; pixel += 2) {
+        const uint16_t value = (pixel[0] << 8) | pixel[1];
+        blue += value & 0x1F;
+        green += (value >> 5) & 0x3F;
+        red += value >> 11;
+      }
+    }
+  }
+
+  // Average color of a region from the last frame built, as 0xRRGGBB
+  uint32_t avgColor(int region) const {
+    if (!regionPixels[region]) return 0;
+
+    uint32_t r = 0, g = 0, b = 0;
+    for (int i = regionStart[region]; i < regionStart[region + 1]; i++) {
+      const ColorTotal& first = totals[runCuts[i].first];
+      const ColorTotal& end = totals[runCuts[i].second];
+      r += end.r - first.r;
+      g += end.g - first.g;
+      b += end.b - first.b;
+    }
+
+    const uint32_t pixels = regionPixels[region];
+    return ((r / pixels) << 16) | ((g / pixels) << 8) | (b / pixels);
+  }
+};
+
+#endif  // REGION_STATS_H
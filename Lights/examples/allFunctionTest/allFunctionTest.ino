@@ -101,7 +101,7 @@ void bootSequence() {
 }
 
 void setup() {
-  currentTime = millis();
+  updateCurrentTime();
   hex.begin();
   bootSequence();
 }
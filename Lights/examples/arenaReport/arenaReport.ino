@@ -0,0 +1,42 @@
+#include <Lights.h>
+
+// Prints how much of the static arena the library uses once a full
+// hexagon is built and has run a few effects, so LIGHTS_ARENA_SIZE can
+// be trimmed to fit. Build with the arena turned on, for example with
+// -DLIGHTS_ARENA_SIZE=32768 in the build flags. Without it every count
+// reads 0.
+
+Hexagon hex;
+
+void printReport() {
+  Serial.print("Arena capacity: ");
+  Serial.print((unsigned long)LightsArena::capacity());
+  Serial.print(" bytes, used: ");
+  Serial.print((unsigned long)LightsArena::used());
+  Serial.print(", high water: ");
+  Serial.print((unsigned long)LightsArena::highWater());
+  Serial.print(", overflows: ");
+  Serial.println((unsigned long)LightsArena::overflows());
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  updateCurrentTime();
+  hex.begin();
+  printReport();
+
+  hex.rainbow(0, 250);
+  hex.colorShift(500, 10);
+}
+
+void loop() {
+  hex.show();
+
+  static MilliSec nextReport = 0;
+  if (currentTime >= nextReport) {
+    printReport();
+    nextReport = currentTime + 5000;
+  }
+}
@@ -15,7 +15,7 @@ void loop() {
   // make sure to call this line at the start of the loop
   // function so the panels know how many milliseconds 
   // have passed and its animations work properly
-  currentTime = millis();
+  updateCurrentTime();
 
 
   MilliSec timePassed = currentTime % 3000;
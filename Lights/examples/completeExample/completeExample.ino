@@ -133,8 +133,10 @@ void setup() {
   Wire.begin(1);
   Wire.onReceive(receiveEvent);
 
-  currentTime = millis();
+  updateCurrentTime();
   hex.begin();
+  // Leaves time between frames for the I2C handler
+  hex.setFrameRate(60);
   bootSequence();
 }
 
@@ -0,0 +1,233 @@
+#include <Lights.h>
+
+#include <stdlib.h>
+
+// Runs every effect on a full hexagon of 80 LED panels and reports how
+// much CPU time Hexagon::show() takes per frame while it plays. The
+// effects are stepped with a virtual clock so every run is identical,
+// and the results are printed to the serial monitor as JSON:
+//
+//   setup_us            time spent starting the effect
+//   ns_per_frame        average time of one Hexagon::show() call
+//   max_frame_us        slowest Hexagon::show() call
+//   functions_scheduled functions added to any scheduler during the run
+//   peak_queue          most functions waiting in the schedulers at once
+//   peak_delayed_leds   most LEDs waiting on a delayed change at once
+//   peak_tweens         most color tweens queued across all panels at once
+//   pushed_frames       panel frames written out to a strip
+//   skipped_frames      panel frames with nothing new to write
+//   allocs_per_frame    heap allocations made by Hexagon::show() per frame
+
+const int frameCount = 600;
+const MilliSec frameLength = 10;
+
+TriPanelData panelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(6, 80, CL_MT, CW, CL_MB),
+  TriPanelData(7, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(8, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(9, 80, CL_MB, CW, CL_RB),
+  TriPanelData(10, 80, CL_LB, CCW, CL_RT)
+};
+
+Hexagon hex(panelData);
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+volatile uint32_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+void* operator new[](size_t size) {
+  allocations++;
+  return malloc(size);
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+template <class Function>
+void forEachScheduler(Function fn) {
+  fn(hex.functionSequence);
+  for (TriPanel* panel : hex.panels) {
+    fn(panel->functionSequence);
+  }
+}
+
+size_t queuedFunctions() {
+  size_t queued = 0;
+  forEachScheduler([&](FunctionScheduler& s) { queued += s.size(); });
+  return queued;
+}
+
+size_t queuedTweens() {
+  size_t queued = 0;
+  for (TriPanel* panel : hex.panels) {
+    queued += panel->tweenCount;
+  }
+  return queued;
+}
+
+size_t delayedLEDs() {
+  size_t delayed = 0;
+  for (TriPanel* panel : hex.panels) {
+    delayed += panel->delayedLEDs.count;
+  }
+  return delayed;
+}
+
+void resetHexagon() {
+  hex.clearFunctions();
+  hex.setBrightness(50);
+  hex.setColor(LED::Color(0, 0, 0));
+  hex.show();
+  forEachScheduler([](FunctionScheduler& s) { s.resetStats(); });
+  hex.resetFrameStats();
+}
+
+bool firstResult = true;
+
+template <class Function>
+void benchmark(const char* name, Function startEffect) {
+  resetHexagon();
+
+  unsigned long start = micros();
+  startEffect();
+  const unsigned long setupTime = micros() - start;
+
+  unsigned long totalTime = 0;
+  unsigned long maxFrameTime = 0;
+  uint32_t frameAllocations = 0;
+  size_t peakDelayedLEDs = delayedLEDs();
+  size_t peakTweens = queuedTweens();
+  size_t peakQueue = queuedFunctions();
+
+  for (int frame = 0; frame < frameCount; frame++) {
+    virtualTime += frameLength;
+
+    const uint32_t allocationsBefore = allocations;
+    start = micros();
+    hex.show();
+    const unsigned long frameTime = micros() - start;
+    frameAllocations += allocations - allocationsBefore;
+
+    totalTime += frameTime;
+    maxFrameTime = std::max(maxFrameTime, frameTime);
+    peakDelayedLEDs = std::max(peakDelayedLEDs, delayedLEDs());
+    peakTweens = std::max(peakTweens, queuedTweens());
+  }
+
+  uint32_t functionsScheduled = 0;
+  forEachScheduler([&](FunctionScheduler& s) {
+    functionsScheduled += s.functionsAdded();
+    peakQueue = std::max(peakQueue, s.peakQueueSize());
+  });
+
+  Serial.print(firstResult ? "\n    " : ",\n    ");
+  firstResult = false;
+  Serial.print("{\"effect\": \"");
+  Serial.print(name);
+  Serial.print("\", \"setup_us\": ");
+  Serial.print(setupTime);
+  Serial.print(", \"ns_per_frame\": ");
+  Serial.print(totalTime * 1000 / frameCount);
+  Serial.print(", \"max_frame_us\": ");
+  Serial.print(maxFrameTime);
+  Serial.print(", \"functions_scheduled\": ");
+  Serial.print(functionsScheduled);
+  Serial.print(", \"peak_queue\": ");
+  Serial.print(peakQueue);
+  Serial.print(", \"peak_delayed_leds\": ");
+  Serial.print(peakDelayedLEDs);
+  Serial.print(", \"peak_tweens\": ");
+  Serial.print(peakTweens);
+  Serial.print(", \"pushed_frames\": ");
+  Serial.print(hex.framesPushed());
+  Serial.print(", \"skipped_frames\": ");
+  Serial.print(hex.framesSkipped());
+  Serial.print(", \"allocs_per_frame\": ");
+  Serial.print((double)frameAllocations / frameCount);
+  Serial.print("}");
+}
+
+void runBenchmarks() {
+  const LEDColor red = LED::Color(255, 0, 0);
+  const LEDColor blue = LED::Color(0, 0, 255);
+
+  Serial.print("{\"frames\": ");
+  Serial.print(frameCount);
+  Serial.print(", \"frame_ms\": ");
+  Serial.print(frameLength);
+  Serial.print(", \"leds\": ");
+  Serial.print(6 * 80);
+  Serial.print(", \"results\": [");
+
+  benchmark("idle", []() {});
+  benchmark("setColor", [=]() { hex.setColor(red); });
+  benchmark("setColorDelayed", [=]() { hex.setColor(red, 3000); });
+  benchmark("fillFromCorner", [=]() {
+    for (TriPanel* panel : hex.panels) panel->fillFromCorner(1, red, 3000);
+  });
+  benchmark("fillToCorner", [=]() {
+    for (TriPanel* panel : hex.panels) panel->fillToCorner(1, blue, 3000);
+  });
+  benchmark("fadeIn", [=]() {
+    hex.setColor(red);
+    hex.setBrightness(0);
+    for (TriPanel* panel : hex.panels) panel->fadeIn(50, true, 3000);
+  });
+  benchmark("fadeOut", [=]() {
+    hex.setColor(red);
+    for (TriPanel* panel : hex.panels) panel->fadeOut(0, true, 3000);
+  });
+  benchmark("breathe", [=]() { hex.breathe(50, 1000, blue); });
+  benchmark("colorSpin", [=]() {
+    for (TriPanel* panel : hex.panels) {
+      panel->fillFromCorner(0.5, red);
+      panel->colorSpin(5, 250);
+    }
+  });
+  benchmark("rainbow", []() { hex.rainbow(0, 250); });
+  benchmark("rainbowTimed", []() { hex.rainbowTimed(5000, 250); });
+  benchmark("tweens", [=]() {
+    // Fills every panel's tween slots with two keyframes per range
+    for (TriPanel* panel : hex.panels) {
+      const uint16_t ranges = LIGHTS_MAX_TWEENS / 2;
+      const uint16_t width = panel->getColor().size() / ranges;
+      for (uint16_t r = 0; r < ranges; r++) {
+        const uint16_t first = r * width;
+        const MilliSec delay = r * 100;
+        panel->tweenPixels(
+          first, first + width - 1, red, blue, 2000, EASE_SINE, delay);
+        panel->tweenPixels(
+          first, first + width - 1, blue, red, 2000, EASE_SINE, delay + 2000);
+      }
+    }
+  });
+  benchmark("colorShift", [=]() {
+    for (size_t i = 0; i < hex.panels.size(); i++) {
+      hex.panels[i]->setColor(i % 2 ? red : blue);
+    }
+    hex.colorShift(100, frameCount * frameLength / 100);
+  });
+
+  Serial.println("\n  ]}");
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  setLightsClock(virtualClock);
+  hex.begin();
+
+  runBenchmarks();
+}
+
+void loop() {}
@@ -0,0 +1,102 @@
+#include <Lights.h>
+
+// Measures how the per-frame cost of a PanelGrid grows with the number of
+// panels. Grids of up to 64 panels of 80 LEDs are laid out as a strip of
+// triangles, each panel touching the one before and after it, and every
+// frame starts a fill or rainbow spreading out from the first panel and
+// shows it. Results are printed to the serial monitor as JSON:
+//
+//   ns_per_frame  average time of the effect and one PanelGrid::show()
+//   ns_per_led    ns_per_frame spread over every LED in the grid
+//   scaling       ns_per_led compared with the smallest grid, near 1.0
+//                 when the cost grows linearly
+//
+// Every panel is driven from the same pin, which is fine for timing as
+// the strips are written one after another either way.
+
+const int frameCount = 20;
+const uint16_t ledsPerPanel = 80;
+const uint16_t gridSizes[] = {6, 16, 32, 64};
+const LEDColor red = LED::Color(255, 0, 0);
+const LEDColor blue = LED::Color(0, 0, 255);
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+unsigned long smallestLedNanos = 0;
+bool firstResult = true;
+
+void benchmark(uint16_t panelCount) {
+  std::vector<TriPanelData> panelData;
+  std::vector<PanelLink> links;
+  panelData.reserve(panelCount);
+  for (uint16_t i = 0; i < panelCount; i++) {
+    // Neighbouring triangles in a strip point opposite ways
+    panelData.push_back(i % 2
+        ? TriPanelData(5, ledsPerPanel, CL_MB, CCW, CL_LB)
+        : TriPanelData(5, ledsPerPanel, CL_MT, CW, CL_LT));
+    if (i) links.push_back({(uint16_t)(i - 1), i});
+  }
+
+  PanelGrid* grid =
+    new PanelGrid(panelData.data(), panelCount, links.data(), links.size());
+  grid->begin();
+  grid->show();
+
+  unsigned long totalTime = 0;
+  for (int frame = 0; frame < frameCount; frame++) {
+    virtualTime += 10;
+
+    const unsigned long start = micros();
+    if (frame % 2) {
+      grid->rainbowFromPanel(0, 512 / panelCount);
+    } else {
+      grid->fillFromPanel(0, frame % 4 ? blue : red);
+    }
+    grid->show();
+    totalTime += micros() - start;
+  }
+  delete grid;
+
+  const unsigned long frameNanos = totalTime * 1000 / frameCount;
+  const unsigned long ledNanos =
+    frameNanos / ((unsigned long)panelCount * ledsPerPanel);
+  if (!smallestLedNanos) {
+    smallestLedNanos = ledNanos ? ledNanos : 1;
+  }
+
+  Serial.print(firstResult ? "\n    " : ",\n    ");
+  firstResult = false;
+  Serial.print("{\"panels\": ");
+  Serial.print(panelCount);
+  Serial.print(", \"leds\": ");
+  Serial.print((unsigned long)panelCount * ledsPerPanel);
+  Serial.print(", \"ns_per_frame\": ");
+  Serial.print(frameNanos);
+  Serial.print(", \"ns_per_led\": ");
+  Serial.print(ledNanos);
+  Serial.print(", \"scaling\": ");
+  Serial.print((float)ledNanos / smallestLedNanos, 2);
+  Serial.print("}");
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  setLightsClock(virtualClock);
+
+  Serial.print("{\"frames\": ");
+  Serial.print(frameCount);
+  Serial.print(", \"leds_per_panel\": ");
+  Serial.print(ledsPerPanel);
+  Serial.print(", \"results\": [");
+
+  for (uint16_t panelCount : gridSizes) {
+    benchmark(panelCount);
+  }
+
+  Serial.println("\n  ]}");
+}
+
+void loop() {}
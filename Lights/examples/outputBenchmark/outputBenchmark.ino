@@ -0,0 +1,105 @@
+#include <Lights.h>
+
+// Measures what gamma correction and dithering add to writing a full
+// hexagon of 80 LED panels out to the strips. Every frame changes the
+// brightness so all 480 pixels are rescaled and rewritten, and each
+// output mode is compared with plain brightness scaling. Results are
+// printed to the serial monitor as JSON:
+//
+//   ns_per_frame        average time of one Hexagon::show() call
+//   extra_us_per_frame  time added per frame over plain scaling
+//   within_budget       whether extra_us_per_frame is under budgetMicros
+//
+// Hexagon::show() includes pushing the strips, which takes about 30us
+// per LED whatever the output mode, so only the difference is the cost
+// of the output stage.
+
+const int frameCount = 500;
+const unsigned long budgetMicros = 1000;
+
+TriPanelData panelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(6, 80, CL_MT, CW, CL_MB),
+  TriPanelData(7, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(8, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(9, 80, CL_MB, CW, CL_RB),
+  TriPanelData(10, 80, CL_LB, CCW, CL_RT)
+};
+
+Hexagon hex(panelData);
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+unsigned long plainFrameNanos = 0;
+bool firstResult = true;
+
+void benchmark(const char* name, bool gamma, bool dithering) {
+  hex.setGammaCorrection(gamma);
+  hex.setDithering(dithering);
+  hex.show();
+
+  unsigned long totalTime = 0;
+  for (int frame = 0; frame < frameCount; frame++) {
+    virtualTime += 10;
+    // Low brightness is where gamma and dithering make a difference
+    hex.setBrightness(frame % 2 ? 40 : 50);
+
+    const unsigned long start = micros();
+    hex.show();
+    totalTime += micros() - start;
+  }
+
+  const unsigned long frameNanos = totalTime * 1000 / frameCount;
+  if (!gamma && !dithering) {
+    plainFrameNanos = frameNanos;
+  }
+  const unsigned long extraMicros =
+    frameNanos > plainFrameNanos ? (frameNanos - plainFrameNanos) / 1000 : 0;
+
+  Serial.print(firstResult ? "\n    " : ",\n    ");
+  firstResult = false;
+  Serial.print("{\"output\": \"");
+  Serial.print(name);
+  Serial.print("\", \"ns_per_frame\": ");
+  Serial.print(frameNanos);
+  Serial.print(", \"extra_us_per_frame\": ");
+  Serial.print(extraMicros);
+  Serial.print(", \"within_budget\": ");
+  Serial.print(extraMicros <= budgetMicros ? "true" : "false");
+  Serial.print("}");
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  setLightsClock(virtualClock);
+  hex.begin();
+
+  // A spread of colors so every level in the tables gets used
+  for (TriPanel* panel : hex.panels) {
+    const uint16_t pixelCount = panel->getColor().size();
+    for (uint16_t i = 0; i < pixelCount; i++) {
+      panel->setPixelColor(
+        i, pgm_read_dword(&rainbowColors[i * 512 / pixelCount]));
+    }
+  }
+
+  Serial.print("{\"frames\": ");
+  Serial.print(frameCount);
+  Serial.print(", \"leds\": ");
+  Serial.print(6 * 80);
+  Serial.print(", \"budget_us\": ");
+  Serial.print(budgetMicros);
+  Serial.print(", \"results\": [");
+
+  benchmark("plain", false, false);
+  benchmark("gamma", true, false);
+  benchmark("dithered", false, true);
+  benchmark("gammaDithered", true, true);
+
+  Serial.println("\n  ]}");
+}
+
+void loop() {}
@@ -0,0 +1,65 @@
+#include <Lights.h>
+
+// Compares reading rainbow colors from the rainbowColors table with
+// working them out from the hue, and how far apart the two look.
+// Results are printed to the serial monitor as JSON:
+//
+//   ns_per_color        average time to get one color
+//   max_difference      largest channel difference from the table
+//
+// To make the panels use the procedural colors, build with
+// -DLIGHTS_PROCEDURAL_RAINBOW=1 in the build flags. Defining it in a
+// sketch doesn't reach the library.
+
+const uint32_t colorCount = 480UL * 1000;
+
+volatile LEDColor sink = 0;
+
+template <class Function>
+unsigned long timeColors(Function color) {
+  LEDColor mixed = 0;
+
+  const unsigned long start = micros();
+  for (uint32_t i = 0; i < colorCount; i++) {
+    mixed ^= color(i * 137);
+  }
+  const unsigned long elapsed = micros() - start;
+
+  sink = mixed;
+  return elapsed * 1000 / colorCount;
+}
+
+int channelDifference(LEDColor a, LEDColor b, int shift) {
+  return abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+}
+
+int maxDifference() {
+  int largest = 0;
+  for (uint32_t hue = 0; hue < 65536; hue += 128) {
+    const LEDColor table = rainbowTableColor(hue);
+    const LEDColor procedural = rainbowHueColor(hue);
+    for (int shift = 0; shift <= 16; shift += 8) {
+      largest = std::max(largest, channelDifference(table, procedural, shift));
+    }
+  }
+  return largest;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  Serial.print("{\"colors\": ");
+  Serial.print(colorCount);
+  Serial.print(", \"results\": [\n    {\"kernel\": \"table\", ");
+  Serial.print("\"ns_per_color\": ");
+  Serial.print(timeColors(rainbowTableColor));
+  Serial.print(", \"max_difference\": 0},\n    {\"kernel\": \"procedural\", ");
+  Serial.print("\"ns_per_color\": ");
+  Serial.print(timeColors(rainbowHueColor));
+  Serial.print(", \"max_difference\": ");
+  Serial.print(maxDifference());
+  Serial.println("}\n  ]}");
+}
+
+void loop() {}
@@ -0,0 +1,79 @@
+#include <Lights.h>
+
+// Measures how long it takes to schedule and then run 10,000 effects
+// with the FunctionScheduler every panel uses, compared to the sorted
+// list the panels used to keep. Results are printed to the serial monitor.
+//
+// 10,000 scheduled functions take roughly 360 KB of RAM, so lower
+// effectCount on boards without PSRAM.
+
+const size_t effectCount = 10000;
+volatile uint32_t effectsRun = 0;
+
+// Spreads the run times out so inserts land all over the queue
+MilliSec runTimeFor(size_t i) { return (i * 7919) % effectCount; }
+
+void benchmarkScheduler() {
+  FunctionScheduler scheduler;
+  effectsRun = 0;
+
+  unsigned long start = micros();
+  for (size_t i = 0; i < effectCount; i++) {
+    scheduler.add([]() { effectsRun++; }, runTimeFor(i));
+  }
+  const unsigned long insertTime = micros() - start;
+
+  start = micros();
+  EffectCommand command;
+  while (scheduler.popDue(effectCount + 1, command)) {
+    scheduler.takeFunction(command)();
+  }
+  const unsigned long drainTime = micros() - start;
+
+  Serial.print("FunctionScheduler insert: ");
+  Serial.print(insertTime);
+  Serial.print("us, drain: ");
+  Serial.print(drainTime);
+  Serial.print("us, ran: ");
+  Serial.println(effectsRun);
+}
+
+void benchmarkSortedList() {
+  std::list<std::pair<MilliSec, std::function<void()>>> sequence;
+  effectsRun = 0;
+
+  unsigned long start = micros();
+  for (size_t i = 0; i < effectCount; i++) {
+    const MilliSec runTime = runTimeFor(i);
+    auto it = sequence.begin();
+    while (it != sequence.end() && it->first < runTime) {
+      ++it;
+    }
+    sequence.insert(it, {runTime, []() { effectsRun++; }});
+  }
+  const unsigned long insertTime = micros() - start;
+
+  start = micros();
+  while (!sequence.empty()) {
+    sequence.front().second();
+    sequence.pop_front();
+  }
+  const unsigned long drainTime = micros() - start;
+
+  Serial.print("Sorted std::list insert: ");
+  Serial.print(insertTime);
+  Serial.print("us, drain: ");
+  Serial.print(drainTime);
+  Serial.print("us, ran: ");
+  Serial.println(effectsRun);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  benchmarkScheduler();
+  benchmarkSortedList();
+}
+
+void loop() {}
@@ -0,0 +1,76 @@
+#include <Lights.h>
+
+// Compares a hexagon with a strip per panel against the same six panels
+// chained on one strip. Every frame rewrites all the panels. Results are
+// printed to the serial monitor as JSON:
+//
+//   ns_per_frame       average time of one Hexagon::show() call
+//   pushes_per_frame   strips written out per frame
+//
+// Each push has its own latch, so one long strip saves five of them a
+// frame as well as five pins.
+
+const int frameCount = 200;
+
+TriPanelData panelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(6, 80, CL_MT, CW, CL_MB),
+  TriPanelData(7, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(8, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(9, 80, CL_MB, CW, CL_RB),
+  TriPanelData(10, 80, CL_LB, CCW, CL_RT)
+};
+
+Hexagon pinPerPanel(panelData);
+// The first panel's data line feeds the rest in the order above
+Hexagon singleStrip(5, panelData);
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+bool firstResult = true;
+
+void benchmark(const char* name, Hexagon& hex) {
+  hex.begin();
+  hex.resetFrameStats();
+
+  unsigned long totalTime = 0;
+  for (int frame = 0; frame < frameCount; frame++) {
+    virtualTime += 10;
+    hex.setRainbow(frame * 256);
+
+    const unsigned long start = micros();
+    hex.show();
+    totalTime += micros() - start;
+  }
+
+  Serial.print(firstResult ? "\n    " : ",\n    ");
+  firstResult = false;
+  Serial.print("{\"layout\": \"");
+  Serial.print(name);
+  Serial.print("\", \"ns_per_frame\": ");
+  Serial.print(totalTime * 1000 / frameCount);
+  Serial.print(", \"pushes_per_frame\": ");
+  Serial.print((float)hex.stripPushes() / frameCount, 2);
+  Serial.print("}");
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  setLightsClock(virtualClock);
+
+  Serial.print("{\"frames\": ");
+  Serial.print(frameCount);
+  Serial.print(", \"leds\": ");
+  Serial.print(6 * 80);
+  Serial.print(", \"results\": [");
+
+  benchmark("pinPerPanel", pinPerPanel);
+  benchmark("singleStrip", singleStrip);
+
+  Serial.println("\n  ]}");
+}
+
+void loop() {}
@@ -0,0 +1,52 @@
+// Stand-in for Adafruit_NeoPixel that keeps pixels in memory. Each strip
+// counts its show() calls and, while recordFrames is set, keeps a copy of
+// its pixels as they were at every show() so tests can compare whole
+// timelines.
+
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <stdint.h>
+
+#include <vector>
+
+typedef uint16_t neoPixelType;
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+ public:
+  std::vector<uint32_t> pixels;
+  std::vector<std::vector<uint32_t>> frames;
+  uint32_t showCount;
+  bool recordFrames;
+  int16_t pin;
+
+  Adafruit_NeoPixel(uint16_t n = 0, int16_t p = 6,
+    neoPixelType type = NEO_GRB + NEO_KHZ800)
+      : pixels(n, 0), showCount(0), recordFrames(false), pin(p) {}
+
+  void begin() {}
+  void show() {
+    showCount++;
+    if (recordFrames) frames.push_back(pixels);
+  }
+  void clear() { pixels.assign(pixels.size(), 0); }
+
+  void setPixelColor(uint16_t n, uint32_t c) {
+    if (n < pixels.size()) pixels[n] = c & 0xFFFFFF;
+  }
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    setPixelColor(n, Color(r, g, b));
+  }
+  uint32_t getPixelColor(uint16_t n) const {
+    return n < pixels.size() ? pixels[n] : 0;
+  }
+  uint16_t numPixels() const { return pixels.size(); }
+
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+};
+
+#endif  // HOST_ADAFRUIT_NEOPIXEL_H
@@ -0,0 +1,55 @@
+// Stand-in for the parts of the Arduino core the library and its examples
+// use, so they can be built and run on a computer. millis() and micros()
+// count from the first call, delay() returns straight away and Serial
+// writes to stdout.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+inline void delay(unsigned long) {}
+
+struct HostSerial {
+  void begin(unsigned long) {}
+  void print(const char* text) { fputs(text, stdout); }
+  void print(char c) { putchar(c); }
+  void print(int value) { printf("%d", value); }
+  void print(unsigned int value) { printf("%u", value); }
+  void print(long value) { printf("%ld", value); }
+  void print(unsigned long value) { printf("%lu", value); }
+  void print(double value, int digits = 2) { printf("%.*f", digits, value); }
+
+  void println() { putchar('\n'); }
+  template <class T>
+  void println(T value) {
+    print(value);
+    println();
+  }
+  void println(double value, int digits) {
+    print(value, digits);
+    println();
+  }
+};
+
+extern HostSerial Serial;
+
+#endif  // HOST_ARDUINO_H
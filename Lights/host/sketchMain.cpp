@@ -0,0 +1,17 @@
+// Runs an example sketch on a computer: setup() once, then loop() as many
+// times as the first argument asks for, none by default.
+
+#include <stdlib.h>
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+  const long loops = argc > 1 ? atol(argv[1]) : 0;
+
+  setup();
+  for (long i = 0; i < loops; i++) {
+    loop();
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+// Built with the arena turned on. Colors have to move between panels and
+// plain vectors the way they do without it, and a scheduler's first
+// LIGHTS_COMMAND_POOL functions have to fit in the room set aside for
+// them rather than leaving old tables behind in the arena.
+
+#include <stdio.h>
+
+#include "Lights.h"
+
+int main() {
+  TriPanel a(5, 80, CL_LT, CW, CL_RB);
+  TriPanel b(10, 80, CL_MT, CW, CL_MB);
+  a.begin();
+  b.begin();
+
+  b.setColor(LED::Color(0, 0, 255));
+  a.setColor(b.getColor());
+  std::vector<LEDColor> colors = a.getColor();
+  b.setColor(colors);
+  b.setColor({LED::Color(255, 0, 0), LED::Color(0, 255, 0)});
+  if (colors.size() != 80 || a.getPixelColor(0) != colors[0] ||
+      b.getPixelColor(0) != LED::Color(255, 0, 0)) {
+    printf("Colors didn't copy between panels and vectors\n");
+    return 1;
+  }
+
+  FunctionScheduler scheduler;
+  const size_t usedBefore = LightsArena::used();
+  for (int i = 0; i < LIGHTS_COMMAND_POOL; i++) {
+    scheduler.add([]() {}, i);
+  }
+  const size_t usedAfter = LightsArena::used();
+
+  printf("Arena used %u bytes before adding %d functions and %u after\n",
+    (unsigned)usedBefore, LIGHTS_COMMAND_POOL, (unsigned)usedAfter);
+  return usedAfter == usedBefore && !LightsArena::overflows() ? 0 : 1;
+}
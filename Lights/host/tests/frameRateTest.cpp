@@ -0,0 +1,59 @@
+// A grid held to a frame rate runs its first frame on the frame grid it
+// was set up with, which can fall before the time begin() read. Effects
+// started at begin() time must still start from the beginning rather
+// than see time run backwards and jump to the end.
+
+#include <stdio.h>
+
+#include "Lights.h"
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+TriPanelData panelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(6, 80, CL_MT, CW, CL_MB),
+  TriPanelData(7, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(8, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(9, 80, CL_MB, CW, CL_RB),
+  TriPanelData(10, 80, CL_LB, CCW, CL_RT)
+};
+
+int main() {
+  setLightsClock(virtualClock);
+  Hexagon hex(panelData);
+  hex.setFrameRate(60);
+
+  virtualTime = 1000;
+  hex.begin();
+  TriPanel* panel = hex.panels[0];
+  panel->fadeIn(200, false, 2000);
+
+  MilliSec lastTime = currentTime;
+  uint8_t lastBrightness = panel->getBrightness();
+  for (; virtualTime <= 3100; virtualTime++) {
+    hex.show();
+    if (currentTime < lastTime) {
+      printf("currentTime went back from %lu to %lu\n", lastTime, currentTime);
+      return 1;
+    }
+    if (panel->getBrightness() < lastBrightness) {
+      printf("Fade went back from %d to %d at %lu\n", lastBrightness,
+        panel->getBrightness(), currentTime);
+      return 1;
+    }
+    if (virtualTime == 1000 && panel->getBrightness() > 60) {
+      printf("Fade jumped to %d on the first frame\n", panel->getBrightness());
+      return 1;
+    }
+    lastTime = currentTime;
+    lastBrightness = panel->getBrightness();
+  }
+
+  if (lastBrightness != 200) {
+    printf("Fade ended at %d instead of 200\n", lastBrightness);
+    return 1;
+  }
+  printf("Fade ran from 50 to 200 without going back\n");
+  return 0;
+}
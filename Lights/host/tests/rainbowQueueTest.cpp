@@ -0,0 +1,36 @@
+// rainbow(0, ...) loops forever by scheduling itself again every turn.
+// Over a long run the panel's scheduler has to stay the same size rather
+// than each turn starting one more spin on top of the last.
+
+#include <stdio.h>
+
+#include "Lights.h"
+
+const MilliSec runLength = 50UL * 60 * 1000;
+const MilliSec frameLength = 10;
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+int main() {
+  setLightsClock(virtualClock);
+  TriPanel panel(5, 80, CL_LT, CW, CL_RB);
+  panel.begin();
+  panel.rainbow(0.0, 250);
+
+  size_t firstSize = 0;
+  size_t largestSize = 0;
+  for (virtualTime = frameLength; virtualTime <= runLength;
+       virtualTime += frameLength) {
+    updateCurrentTime();
+    panel.show();
+
+    const size_t size = panel.functionSequence.size();
+    if (!firstSize) firstSize = size;
+    largestSize = std::max(largestSize, size);
+  }
+
+  printf("Queue held %u commands after the first frame and %u at most\n",
+    (unsigned)firstSize, (unsigned)largestSize);
+  return largestSize <= firstSize ? 0 : 1;
+}
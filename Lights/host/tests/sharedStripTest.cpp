@@ -0,0 +1,37 @@
+// A hexagon on one strip pushes that strip once when it begins, not once
+// per panel, and a layout without one panel in each location is turned
+// down before any panel is made.
+
+#include <stdio.h>
+
+#include "Lights.h"
+
+TriPanelData panelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(5, 80, CL_MT, CW, CL_MB),
+  TriPanelData(5, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(5, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(5, 80, CL_MB, CW, CL_RB),
+  TriPanelData(5, 80, CL_LB, CCW, CL_RT)
+};
+
+TriPanelData badPanelData[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(5, 80, CL_LT, CW, CL_MB),
+  TriPanelData(5, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(5, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(5, 80, CL_MB, CW, CL_RB),
+  TriPanelData(5, 80, CL_LB, CCW, CL_RT)
+};
+
+int main() {
+  Hexagon hex(5, panelData);
+  hex.begin();
+  const uint32_t pushes = hex.panels[0]->getStrip().showCount;
+  printf("Shared strip pushed %u times by begin()\n", (unsigned)pushes);
+  if (pushes != 1) return 1;
+
+  Hexagon badHex(5, badPanelData);
+  printf("Bad layout built %u panels\n", (unsigned)badHex.panels.size());
+  return badHex.panels.empty() ? 0 : 1;
+}
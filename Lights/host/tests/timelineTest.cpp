@@ -0,0 +1,170 @@
+// Plays effects on a hexagon against a virtual clock and hashes what is
+// on the strips after every millisecond. Each effect is started twice,
+// once through the double overloads and once through the Ratio ones, and
+// both timelines have to match a hash recorded from an earlier library,
+// so neither path changes a single pixel.
+//
+//   timelineTest fill|spin|rainbow|shift|evenShift|delayedShift
+//
+// Fades and breathe aren't covered: they have run from elapsed time
+// rather than counted steps since before Ratio, so they never matched.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Lights.h"
+
+const MilliSec runLength = 6000;
+
+const LEDColor red = 0xFF0000;
+const LEDColor green = 0x00FF00;
+const LEDColor blue = 0x0000FF;
+
+// Panels of a few lengths so rounding differences would show up
+const TriPanelData mixedPanels[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(10, 80, CL_MT, CW, CL_MB),
+  TriPanelData(6, 41, CL_RT, CCW, CL_LB),
+  TriPanelData(11, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(12, 62, CL_MB, CW, CL_RB),
+  TriPanelData(9, 80, CL_LB, CCW, CL_RT)
+};
+
+const TriPanelData evenPanels[] = {
+  TriPanelData(5, 80, CL_LT, CW, CL_RB),
+  TriPanelData(10, 80, CL_MT, CW, CL_MB),
+  TriPanelData(6, 80, CL_RT, CCW, CL_LB),
+  TriPanelData(11, 80, CL_RB, CCW, CL_RB),
+  TriPanelData(12, 80, CL_MB, CW, CL_RB),
+  TriPanelData(9, 80, CL_LB, CCW, CL_RT)
+};
+
+const PanelLink ring[] = {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 0}};
+
+MilliSec virtualTime = 0;
+MilliSec virtualClock() { return virtualTime; }
+
+// Fractions are ones a double holds exactly, so both paths should agree
+struct DoubleArgs {
+  static double ratio(int num, int den) { return (double)num / den; }
+};
+
+struct RatioArgs {
+  static Ratio ratio(int num, int den) { return Ratio(Ratio::ONE * num / den); }
+};
+
+template <class Args>
+void startFill(PanelGrid& grid) {
+  grid.panels[1]->fillFromCorner(Args::ratio(1, 1), red, CL_RT, 500);
+  grid.panels[2]->fillFromCorner(Args::ratio(1, 2), green, 700);
+  grid.panels[3]->fillToCorner(Args::ratio(1, 1), blue, 400);
+  grid.panels[5]->fillToCorner(Args::ratio(3, 4), 0xFF8000, 900);
+  grid.panels[4]->setColor(0x123456, 300);
+  grid.panels[0]->setColor(std::vector<LEDColor>{1, 2, 3, 4, 5, 6, 7});
+}
+
+template <class Args>
+void startSpin(PanelGrid& grid) {
+  grid.panels[0]->fillFromCorner(Args::ratio(1, 2), red, 0);
+  grid.panels[0]->colorSpin(Args::ratio(2, 1), 250);
+  grid.panels[1]->rainbow(Args::ratio(1, 1), 200);
+  grid.panels[2]->fillFromCorner(Args::ratio(1, 4), blue, 0);
+  grid.panels[2]->colorSpin(Args::ratio(3, 4), 180);
+}
+
+template <class Args>
+void startRainbow(PanelGrid& grid) {
+  grid.rainbow(Args::ratio(1, 2), 245);
+  grid.panels[3]->rainbowTimed(3000, 240);
+}
+
+template <class Args>
+void startShift(PanelGrid& grid) {
+  for (int i = 0; i < 6; i++) {
+    grid.panels[i]->setColor(0x10101 * (i + 1) * 20);
+  }
+  grid.panels[0]->fillFromCorner(Args::ratio(3, 8), 0xFF00FF, 0);
+  grid.colorShift(100, 8);
+}
+
+// Shifts while delayed changes are still waiting. Colors are set outright
+// by a shift, so changes that hadn't happened yet never do.
+template <class Args>
+void startDelayedShift(PanelGrid& grid) {
+  startShift<Args>(grid);
+  grid.panels[5]->setColor(green, 50);
+  grid.panels[2]->setColor(red, 250);
+  grid.panels[1]->setPixelColor(10, blue, 450);
+}
+
+struct Scenario {
+  const char* name;
+  const TriPanelData* panelData;
+  void (*startDoubles)(PanelGrid&);
+  void (*startRatios)(PanelGrid&);
+  uint64_t expectedHash;
+};
+
+// fill, spin, rainbow and evenShift were recorded from the library just
+// before Ratio (ec6c7b3), which gives the same as the original library.
+// shift was recorded from the original library: just before Ratio,
+// panels of different lengths were stretched again on every swap and
+// gave 0xda9570e9e2248e4b, until shifting them directly put it back.
+// delayedShift was recorded once swapping panels cancelled their delayed
+// changes. Shifting the same panels the way different lengths are shifted
+// gives the same hash.
+const Scenario scenarios[] = {
+  {"fill", mixedPanels, startFill<DoubleArgs>, startFill<RatioArgs>,
+    0x7a7e81fad247d1d1ULL},
+  {"spin", mixedPanels, startSpin<DoubleArgs>, startSpin<RatioArgs>,
+    0x0da2f2a04b01fdfbULL},
+  {"rainbow", mixedPanels, startRainbow<DoubleArgs>, startRainbow<RatioArgs>,
+    0x3c3aa64912177ccbULL},
+  {"shift", mixedPanels, startShift<DoubleArgs>, startShift<RatioArgs>,
+    0x7cbc02dc7f375babULL},
+  {"evenShift", evenPanels, startShift<DoubleArgs>, startShift<RatioArgs>,
+    0x0904d86fb6132d43ULL},
+  {"delayedShift", evenPanels, startDelayedShift<DoubleArgs>,
+    startDelayedShift<RatioArgs>, 0x2bff5ed33ee38423ULL}
+};
+
+uint64_t timelineHash(
+  const TriPanelData* panelData, void (*start)(PanelGrid&)) {
+  virtualTime = 0;
+  PanelGrid grid(panelData, 6, ring, 6);
+  grid.begin();
+  start(grid);
+
+  // FNV-1a over every pixel of every strip, every millisecond
+  uint64_t hash = 1469598103934665603ULL;
+  for (virtualTime = 1; virtualTime <= runLength; virtualTime++) {
+    updateCurrentTime();
+    grid.show();
+    for (TriPanel* panel : grid.panels) {
+      for (uint32_t pixel : panel->getStrip().pixels) {
+        hash = (hash ^ pixel) * 1099511628211ULL;
+      }
+    }
+  }
+  return hash;
+}
+
+int main(int argc, char** argv) {
+  setLightsClock(virtualClock);
+
+  for (const Scenario& scenario : scenarios) {
+    if (argc > 1 && strcmp(argv[1], scenario.name)) continue;
+
+    const uint64_t doubles =
+      timelineHash(scenario.panelData, scenario.startDoubles);
+    const uint64_t ratios =
+      timelineHash(scenario.panelData, scenario.startRatios);
+    printf("%s: doubles %016llx, ratios %016llx, expected %016llx\n",
+      scenario.name, (unsigned long long)doubles, (unsigned long long)ratios,
+      (unsigned long long)scenario.expectedHash);
+    if (doubles != scenario.expectedHash || ratios != scenario.expectedHash) {
+      return 1;
+    }
+  }
+  return 0;
+}
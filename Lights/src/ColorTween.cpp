@@ -0,0 +1,31 @@
+#ifndef MILO_COLOR_TWEEN
+#define MILO_COLOR_TWEEN
+
+#include "Lights.h"
+
+LEDColor blendColor(LEDColor from, LEDColor to, uint16_t progress) {
+  LEDColor blended = 0;
+  for (uint8_t shift = 0; shift <= 16; shift += 8) {
+    const uint32_t start = (from >> shift) & 0xFF;
+    const uint32_t end = (to >> shift) & 0xFF;
+    const uint32_t channel =
+      (start * (0xFFFF - progress) + end * progress + 0x7FFF) / 0xFFFF;
+    blended |= channel << shift;
+  }
+  return blended;
+}
+
+LEDColor ColorTween::colorAt(MilliSec time) const {
+  if (!started(time)) return from;
+
+  return blendColor(
+    from, to, ease(easing, timeProgress(time - startTime, duration)));
+}
+
+bool ColorTween::started(MilliSec time) const { return time >= startTime; }
+
+bool ColorTween::finished(MilliSec time) const {
+  return started(time) && time - startTime >= duration;
+}
+
+#endif  // MILO_COLOR_TWEEN
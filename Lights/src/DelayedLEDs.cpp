@@ -0,0 +1,35 @@
+#ifndef MILO_DELAYED_LEDS
+#define MILO_DELAYED_LEDS
+
+#include "Lights.h"
+
+const MilliSec DelayedLEDs::NO_CHANGE;
+
+DelayedLEDs::DelayedLEDs() : count(0), nextChangeTime(NO_CHANGE) {}
+
+DelayedLEDs::~DelayedLEDs() {}
+
+bool DelayedLEDs::empty() const { return !count; }
+
+void DelayedLEDs::add(MilliSec changeTime) {
+  count++;
+  if (changeTime < nextChangeTime) {
+    nextChangeTime = changeTime;
+  }
+}
+
+void DelayedLEDs::remove() {
+  if (count) {
+    count--;
+  }
+  if (!count) {
+    nextChangeTime = NO_CHANGE;
+  }
+}
+
+void DelayedLEDs::clear() {
+  count = 0;
+  nextChangeTime = NO_CHANGE;
+}
+
+#endif  // MILO_DELAYED_LEDS
@@ -0,0 +1,36 @@
+#ifndef MILO_DIRTY_RANGE
+#define MILO_DIRTY_RANGE
+
+#include "Lights.h"
+
+DirtyRange::DirtyRange() { clear(); }
+
+DirtyRange::~DirtyRange() {}
+
+bool DirtyRange::empty() const {
+  return !pixelsChanged() && !brightnessChanged;
+}
+
+bool DirtyRange::pixelsChanged() const { return first <= last; }
+
+void DirtyRange::mark(uint16_t stripIndex) { mark(stripIndex, stripIndex); }
+
+void DirtyRange::mark(uint16_t firstIndex, uint16_t lastIndex) {
+  if (firstIndex < first) {
+    first = firstIndex;
+  }
+  if (lastIndex > last) {
+    last = lastIndex;
+  }
+}
+
+void DirtyRange::markBrightness() { brightnessChanged = true; }
+
+void DirtyRange::clear() {
+  // An empty range has its ends crossed
+  first = (uint16_t)-1;
+  last = 0;
+  brightnessChanged = false;
+}
+
+#endif  // MILO_DIRTY_RANGE
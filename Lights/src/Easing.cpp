@@ -0,0 +1,43 @@
+#ifndef MILO_EASING
+#define MILO_EASING
+
+#include "Lights.h"
+
+// (1 - cos(pi * x)) / 2 sampled at 33 evenly spaced points
+static const uint16_t PROGMEM sineCurve[33] = {0, 158, 630, 1411, 2494, 3869,
+  5522, 7438, 9597, 11980, 14563, 17321, 20228, 23256, 26375, 29556, 32767,
+  35979, 39160, 42279, 45307, 48214, 50972, 53555, 55938, 58097, 60013, 61666,
+  63041, 64124, 64905, 65377, 65535};
+
+uint16_t ease(Easing easing, uint16_t progress) {
+  switch (easing) {
+    case EASE_GAMMA: {
+      // 0.8x^2 + 0.2x^3 stays within 1% of x^2.2
+      const uint32_t squared = ((uint32_t)progress * progress) >> 16;
+      const uint32_t cubed = (squared * progress) >> 16;
+      return (squared * 4 + cubed) / 5;
+    }
+    case EASE_SINE: {
+      const uint8_t index = progress >> 11;
+      const uint32_t remainder = progress & 0x7FF;
+      const uint16_t low = pgm_read_word(&sineCurve[index]);
+      const uint16_t high = pgm_read_word(&sineCurve[index + 1]);
+      return low + (((high - low) * remainder) >> 11);
+    }
+    default:
+      return progress;
+  }
+}
+
+uint16_t timeProgress(MilliSec elapsed, MilliSec duration) {
+  if (elapsed >= duration) return 0xFFFF;
+
+  // Keeps elapsed * 0xFFFF inside 32 bits for long durations
+  while (duration > 0xFFFF) {
+    duration >>= 1;
+    elapsed >>= 1;
+  }
+  return (elapsed * 0xFFFF) / duration;
+}
+
+#endif  // MILO_EASING
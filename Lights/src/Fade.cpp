@@ -0,0 +1,80 @@
+#ifndef MILO_FADE
+#define MILO_FADE
+
+#include "Lights.h"
+
+Fade::Fade()
+    : from(0),
+      to(0),
+      startTime(0),
+      duration(0),
+      easing(EASE_LINEAR),
+      active(false),
+      breathing(false) {}
+
+Fade::~Fade() {}
+
+void Fade::start(uint8_t fromBrightness, uint8_t toBrightness,
+  MilliSec fadeDuration, Easing fadeEasing) {
+  from = fromBrightness;
+  to = toBrightness;
+  startTime = currentTime;
+  duration = fadeDuration;
+  easing = fadeEasing;
+  active = true;
+  breathing = false;
+}
+
+void Fade::startBreathing(
+  uint8_t maxBrightness, MilliSec fadeDuration, Easing fadeEasing) {
+  start(0, maxBrightness, fadeDuration, fadeEasing);
+  breathing = true;
+}
+
+void Fade::stop() {
+  active = false;
+  breathing = false;
+}
+
+uint8_t Fade::brightnessAt(MilliSec time) {
+  if (!duration) {
+    active = breathing;
+    return to;
+  }
+
+  MilliSec elapsed = time - startTime;
+  uint8_t low = from;
+  uint8_t high = to;
+
+  if (breathing) {
+    // Rise, hold for half the fade time, then fall back to the start
+    const MilliSec hold = duration / 2;
+    elapsed %= duration * 2 + hold;
+
+    if (elapsed >= duration + hold) {
+      elapsed -= duration + hold;
+      low = to;
+      high = from;
+    }
+    else if (elapsed >= duration) {
+      return to;
+    }
+  }
+  else if (elapsed >= duration) {
+    active = false;
+    return to;
+  }
+
+  const uint16_t progress = timeProgress(elapsed, duration);
+  if (high >= low) {
+    const uint32_t eased = ease(easing, progress);
+    return low + ((high - low) * eased + 0x7FFF) / 0xFFFF;
+  }
+
+  // Falling fades run the curve backwards so a gamma fade out dims
+  // evenly to the eye just like a fade in does
+  const uint32_t remaining = ease(easing, 0xFFFF - progress);
+  return high + ((low - high) * remaining + 0x7FFF) / 0xFFFF;
+}
+
+#endif  // MILO_FADE
@@ -0,0 +1,122 @@
+#ifndef MILO_FUNCTION_SCHEDULER
+#define MILO_FUNCTION_SCHEDULER
+
+#include "Lights.h"
+
+FunctionScheduler::FunctionScheduler()
+    : nextOrder(0), addedCount(0), peakSize(0) {
+  queue.reserve(LIGHTS_COMMAND_POOL);
+  functions.reserve(LIGHTS_COMMAND_POOL);
+  freeFunctions.reserve(LIGHTS_COMMAND_POOL);
+}
+
+FunctionScheduler::~FunctionScheduler() {}
+
+bool FunctionScheduler::runsAfter(
+  const EffectCommand& a, const EffectCommand& b) {
+  if (a.runTime != b.runTime) {
+    return a.runTime > b.runTime;
+  }
+  return a.order > b.order;
+}
+
+void FunctionScheduler::push(EffectCommand command) {
+  command.order = nextOrder++;
+  queue.push_back(command);
+  std::push_heap(queue.begin(), queue.end(), runsAfter);
+
+  if (queue.size() > peakSize) {
+    peakSize = queue.size();
+  }
+}
+
+void FunctionScheduler::add(CommandOp op, int16_t arg, MilliSec runTime,
+  uint16_t repeats, MilliSec interval) {
+  EffectCommand command;
+  command.runTime = runTime;
+  command.interval = interval;
+  command.repeats = repeats;
+  command.op = op;
+  command.arg = arg;
+  push(command);
+  addedCount++;
+}
+
+void FunctionScheduler::add(std::function<void()> fn, MilliSec runTime) {
+  int16_t slot;
+  if (freeFunctions.empty()) {
+    slot = functions.size();
+    functions.push_back(std::move(fn));
+  }
+  else {
+    slot = freeFunctions.back();
+    freeFunctions.pop_back();
+    functions[slot] = std::move(fn);
+  }
+
+  add(OP_FUNCTION, slot, runTime);
+}
+
+bool FunctionScheduler::popDue(MilliSec time, EffectCommand& command) {
+  if (queue.empty() || queue.front().runTime >= time) {
+    return false;
+  }
+
+  std::pop_heap(queue.begin(), queue.end(), runsAfter);
+  command = queue.back();
+  queue.pop_back();
+
+  if (command.repeats) {
+    EffectCommand next = command;
+    next.runTime += next.interval;
+    next.repeats--;
+    push(next);
+  }
+
+  // Restart the tie breaker whenever the queue drains so it never wraps
+  if (queue.empty()) {
+    nextOrder = 0;
+  }
+  return true;
+}
+
+std::function<void()> FunctionScheduler::takeFunction(
+  const EffectCommand& command) {
+  std::function<void()> fn;
+  if (command.op != OP_FUNCTION || command.arg < 0 ||
+      command.arg >= (int16_t)functions.size()) {
+    return fn;
+  }
+
+  fn.swap(functions[command.arg]);
+  freeFunctions.push_back(command.arg);
+  return fn;
+}
+
+bool FunctionScheduler::empty() const { return queue.empty(); }
+
+size_t FunctionScheduler::size() const { return queue.size(); }
+
+void FunctionScheduler::reserve(size_t count) {
+  queue.reserve(count);
+  functions.reserve(count);
+  freeFunctions.reserve(count);
+}
+
+void FunctionScheduler::clear() {
+  queue.clear();
+  functions.clear();
+  freeFunctions.clear();
+  nextOrder = 0;
+}
+
+uint32_t FunctionScheduler::functionsAdded() const { return addedCount; }
+
+size_t FunctionScheduler::peakQueueSize() const { return peakSize; }
+
+void FunctionScheduler::resetStats() {
+  addedCount = 0;
+  peakSize = queue.size();
+}
+
+#endif  // MILO_FUNCTION_SCHEDULER
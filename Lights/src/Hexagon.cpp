@@ -3,9 +3,6 @@
 
 #include "Lights.h"
 
-
-MilliSec currentTime = 0;
-
 /*
   1 2 3
   🔺🔻🔺
@@ -20,16 +17,20 @@ Hexagon::Hexagon() {
   static TriPanel MB(12, 80, CL_MB, CW, CL_RB);
   static TriPanel LB(9, 80, CL_LB, CCW, CL_RT);
 
-  panels.push_back(&LT);
-  panels.push_back(&MT);
-  panels.push_back(&RT);
-  panels.push_back(&RB);
-  panels.push_back(&MB);
-  panels.push_back(&LB);
+  reservePanels(6);
+  addPanel(&LT);
+  addPanel(&MT);
+  addPanel(&RT);
+  addPanel(&RB);
+  addPanel(&MB);
+  addPanel(&LB);
+
+  linkRing();
 }
 
-Hexagon::Hexagon(TriPanelData pd[]) {
-  std::vector<bool> panelLocationCheck(6, false);
+// Prints what's wrong with a layout that isn't one of each location
+static bool checkLayout(const TriPanelData pd[]) {
+  bool panelLocationCheck[6] = {false};
 
   for (size_t i = 0; i < 6; i++) {
     CornerLocation overallLocation = pd[i].local;
@@ -38,7 +39,7 @@ Hexagon::Hexagon(TriPanelData pd[]) {
         "You supplied two of more panels that have the same location as "
         "panel ");
       Serial.println(i);
-      return;
+      return false;
     }
 
     panelLocationCheck[overallLocation] = true;
@@ -46,7 +47,7 @@ Hexagon::Hexagon(TriPanelData pd[]) {
 
   for (size_t i = 0; i < 6; i++) {
     if (!panelLocationCheck[i]) {
-      std::string missingLocation = "";
+      const char* missingLocation = "";
       switch (i) {
         case CL_MT:
           missingLocation = "MIDDLE TOP";
@@ -68,11 +69,17 @@ Hexagon::Hexagon(TriPanelData pd[]) {
           break;
       }
       Serial.print("You are missing the ");
-      Serial.print(missingLocation.c_str());
+      Serial.print(missingLocation);
       Serial.println(" panel.");
     }
   }
 
+  return true;
+}
+
+Hexagon::Hexagon(TriPanelData pd[]) {
+  if (!checkLayout(pd)) return;
+
   static TriPanel a(
     pd[0].pin, pd[0].numLeds, pd[0].local, pd[0].spin, pd[0].startLocation);
   static TriPanel b(
@@ -86,108 +93,42 @@ Hexagon::Hexagon(TriPanelData pd[]) {
   static TriPanel f(
     pd[5].pin, pd[5].numLeds, pd[5].local, pd[5].spin, pd[5].startLocation);
 
-  panels.push_back(&a);
-  panels.push_back(&b);
-  panels.push_back(&c);
-  panels.push_back(&d);
-  panels.push_back(&e);
-  panels.push_back(&f);
-}
+  reservePanels(6);
+  addPanel(&a);
+  addPanel(&b);
+  addPanel(&c);
+  addPanel(&d);
+  addPanel(&e);
+  addPanel(&f);
 
-Hexagon::~Hexagon() {}
-
-void Hexagon::playFunctionSequence() {
-  while (!functionSequence.empty()) {
-    const MilliSec waitTime = functionSequence.front().first;
-    const std::function<void()> fn = functionSequence.front().second;
-    const bool timesUp = waitTime < currentTime;
-    if (timesUp) {
-      functionSequence.pop_front();
-      fn();
-    }
-    else if (!timesUp) {
-      return;
-    }
-  }
-}
-
-template <class Function>
-void Hexagon::forEachPanel(Function fn) {
-  for (TriPanel* panel : panels) {
-    fn(panel);
-  }
+  linkRing();
 }
 
-void Hexagon::breathe(
-  uint8_t maxBrightness, MilliSec fadeDuration, LEDColor color) {
-  forEachPanel([=](TriPanel* panel) {
-    panel->breathe(maxBrightness, fadeDuration, color);
-  });
-}
+// A bad layout is turned down before the shared strip or any panel is made
+Hexagon::Hexagon(int pin, TriPanelData pd[])
+    : PanelGrid(pin, pd, checkLayout(pd) ? 6 : 0, nullptr, 0) {
+  if (panels.empty()) return;
 
-void Hexagon::colorShift(MilliSec timeDelay, uint16_t shifts) {
-  for (size_t s = 0; s < shifts; s++) {
-    runFunctionLater(
-      [this, timeDelay]() {
-        std::vector<LEDColor> lastPanelColor = panels[5]->getColor();
-        for (size_t i = 5; i; i--) {
-          panels[i]->setColor(panels[i - 1]->getColor());
-        }
-
-        panels[0]->setColor(lastPanelColor);
-      },
-      timeDelay * (s + 1));
-  }
+  linkRing();
 }
 
-void Hexagon::rainbowTimed(MilliSec duration, uint8_t speed) {
-  forEachPanel([=](TriPanel* panel) { panel->rainbowTimed(duration, speed); });
-}
+Hexagon::~Hexagon() {}
 
-void Hexagon::rainbow(double loops, uint8_t speed) {
-  forEachPanel([=](TriPanel* panel) { panel->rainbow(loops, speed); });
-}
+void Hexagon::linkRing() {
+  // Each panel shares a side with the ones either side of it going round
+  const CornerLocation ring[6] = {CL_LT, CL_MT, CL_RT, CL_RB, CL_MB, CL_LB};
 
-void Hexagon::runFunctionLater(std::function<void()> fn, MilliSec timeDelay) {
-  timeDelay += currentTime;
-  if (functionSequence.empty()) {
-    functionSequence.push_back({timeDelay, fn});
-    return;
+  uint16_t panelAt[6] = {0};
+  for (uint16_t i = 0; i < panels.size(); i++) {
+    panelAt[panels[i]->getLocation()] = i;
   }
 
-  for (auto it = functionSequence.begin(); it != functionSequence.end(); ++it) {
-    if (it->first >= timeDelay) {
-      functionSequence.insert(it, {timeDelay, fn});
-      return;
-    }
+  PanelLink links[6];
+  for (int i = 0; i < 6; i++) {
+    links[i].a = panelAt[ring[i]];
+    links[i].b = panelAt[ring[(i + 1) % 6]];
   }
-
-  functionSequence.push_back({timeDelay, fn});
-}
-
-void Hexagon::clearFunctions() {
-  forEachPanel([](TriPanel* panel) { panel->clearFunctions(); });
-  functionSequence.clear();
-}
-
-void Hexagon::begin(uint8_t brightness) {
-  currentTime = millis();
-  forEachPanel([brightness](TriPanel* panel) { panel->begin(brightness); });
-  setColor(LED::Color(0, 0, 0));
-}
-
-void Hexagon::setBrightness(uint8_t b) {
-  forEachPanel([b](TriPanel* panel) { panel->setBrightness(b); });
-}
-
-void Hexagon::setColor(LEDColor color, MilliSec timeDelay) {
-  forEachPanel([=](TriPanel* panel) { panel->setColor(color, timeDelay); });
-}
-
-void Hexagon::show() {
-  playFunctionSequence();
-  forEachPanel([](TriPanel* panel) { panel->show(); });
-  currentTime = millis();
+  setLinks(links, 6);
 }
 
 #endif  // MILO_HEXAGON
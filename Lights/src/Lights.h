@@ -4,11 +4,47 @@
 #include "Adafruit_NeoPixel.h"
 #include "Arduino.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
+/*
+  Settings that change how the library is compiled. They have to be build
+  flags, for example -DLIGHTS_MAX_TWEENS=16 in the board's build flags, so
+  the library's own files see them. Defining one in a sketch before
+  including Lights.h does nothing for the library and, for the ones that
+  size classes, leaves the sketch with a different layout of them than
+  the library was built with.
+*/
+
+// How many color tweens each panel can run at once
+#ifndef LIGHTS_MAX_TWEENS
+#define LIGHTS_MAX_TWEENS 32
+#endif
+
+// Has effects work rainbow colors out from the hue instead of reading them
+// from the rainbowColors table. The table stays in flash either way, as
+// rainbowTableColor() still reads it.
+#ifndef LIGHTS_PROCEDURAL_RAINBOW
+#define LIGHTS_PROCEDURAL_RAINBOW 0
+#endif
+
+// How many scheduled commands each scheduler has room for before its pool
+// has to grow
+#ifndef LIGHTS_COMMAND_POOL
+#define LIGHTS_COMMAND_POOL 32
+#endif
+
+// LIGHTS_ARENA_SIZE, when defined, is the size in bytes of a static block
+// all of the library's arrays are taken from instead of the heap
+
+// Exponent of the gamma curve used when a panel has gamma correction on
+#ifndef LIGHTS_GAMMA
+#define LIGHTS_GAMMA 2.2
+#endif
+
+#include <algorithm>
 #include <functional>
 #include <list>
-#include <map>
 #include <vector>
 
 enum SideLocation { SL_TOP = 0, SL_RIGHT = 1, SL_BOTTOM = 2, SL_LEFT = 3 };
@@ -25,9 +61,179 @@ enum CornerLocation { CL_LT, CL_MT, CL_RT, CL_RB, CL_MB, CL_LB };
 
 enum LoopDirection { CW, CCW };
 
+enum Easing { EASE_LINEAR, EASE_GAMMA, EASE_SINE };
+
 typedef uint32_t LEDColor;
 typedef unsigned long MilliSec;
 
+/*
+  A fraction in 16.16 fixed point, so Ratio(Ratio::ONE) is a whole and
+  Ratio(Ratio::ONE / 2) a half. The constructor is explicit so plain
+  numbers still pick the double overloads that wrap the Ratio ones.
+*/
+struct Ratio {
+  static const int32_t ONE = 65536;
+
+  int32_t q16;
+
+  constexpr explicit Ratio(int32_t q16) : q16(q16) {}
+
+  static constexpr Ratio fromDouble(double value) {
+    return Ratio(value * ONE + (value < 0 ? -0.5 : 0.5));
+  }
+
+  // Rounds count times the ratio to the nearest whole, halves away from 0
+  constexpr int32_t of(int32_t count) const {
+    return q16 < 0 ? -(int32_t)(((int64_t)count * -q16 + ONE / 2) >> 16)
+                   : (int32_t)(((int64_t)count * q16 + ONE / 2) >> 16);
+  }
+
+  constexpr Ratio operator-() const { return Ratio(-q16); }
+};
+
+/*
+  Lookup tables for how the sides and corners of a panel relate, usable in
+  constant expressions so a layout known at compile time costs nothing to
+  work out. Tables are indexed by the enums above.
+*/
+namespace PanelGeometry {
+  // Panels in the MT, LB and RB spots point down and have a top side,
+  // the others point up and have a bottom side
+  constexpr bool pointsDownTable[6] = {false, true, false, true, false, true};
+
+  constexpr CornerLocation oppositeCornerTable[6] = {
+    CL_RB, CL_MB, CL_LB, CL_LT, CL_MT, CL_RT};
+
+  constexpr SideLocation oppositeSideTable[6] = {
+    SL_RIGHT, SL_BOTTOM, SL_LEFT, SL_LEFT, SL_TOP, SL_RIGHT};
+
+  // The two sides that meet at a corner, the second is always left or right
+  constexpr SideLocation cornerSidesTable[6][2] = {{SL_TOP, SL_LEFT},
+    {SL_RIGHT, SL_LEFT}, {SL_TOP, SL_RIGHT}, {SL_BOTTOM, SL_RIGHT},
+    {SL_RIGHT, SL_LEFT}, {SL_BOTTOM, SL_LEFT}};
+
+  // [start corner][direction]
+  constexpr SideLocation firstSideTable[6][2] = {{SL_TOP, SL_LEFT},
+    {SL_RIGHT, SL_LEFT}, {SL_RIGHT, SL_TOP}, {SL_BOTTOM, SL_RIGHT},
+    {SL_LEFT, SL_RIGHT}, {SL_LEFT, SL_BOTTOM}};
+
+  // [points down][side][direction]
+  constexpr SideLocation nextSideTable[2][4][2] = {
+    {{SL_RIGHT, SL_LEFT}, {SL_BOTTOM, SL_LEFT}, {SL_LEFT, SL_RIGHT},
+      {SL_RIGHT, SL_BOTTOM}},
+    {{SL_RIGHT, SL_LEFT}, {SL_LEFT, SL_TOP}, {SL_LEFT, SL_RIGHT},
+      {SL_TOP, SL_RIGHT}}};
+
+  constexpr bool pointsDown(CornerLocation local) {
+    return pointsDownTable[local];
+  }
+
+  constexpr CornerLocation oppositeCorner(CornerLocation corner) {
+    return oppositeCornerTable[corner];
+  }
+
+  constexpr SideLocation oppositeSide(CornerLocation corner) {
+    return oppositeSideTable[corner];
+  }
+
+  constexpr SideLocation cornerSide(CornerLocation corner, int which) {
+    return cornerSidesTable[corner][which];
+  }
+
+  // The side on the other side of a corner from the side given
+  constexpr SideLocation otherCornerSide(
+    CornerLocation corner, SideLocation side) {
+    return side == cornerSide(corner, 1) ? cornerSide(corner, 0)
+                                         : cornerSide(corner, 1);
+  }
+
+  constexpr SideLocation firstSide(
+    CornerLocation start, LoopDirection direction) {
+    return firstSideTable[start][direction];
+  }
+
+  constexpr SideLocation nextSide(
+    CornerLocation local, SideLocation side, LoopDirection direction) {
+    return nextSideTable[pointsDown(local)][side][direction];
+  }
+
+  // Side the nth segment of a strip runs along
+  constexpr SideLocation segmentSide(CornerLocation local,
+    LoopDirection direction, CornerLocation start, int segment) {
+    return segment ? nextSide(local,
+                       segmentSide(local, direction, start, segment - 1),
+                       direction)
+                   : firstSide(start, direction);
+  }
+
+  // First strip index of the nth segment of a strip
+  constexpr uint16_t segmentStart(uint16_t numLeds, int segment) {
+    return segment ? ((numLeds - 2) / 3 + 1) * segment : 0;
+  }
+}
+
+/*
+  Tables for the output stage, built by the compiler. Channel levels are
+  mapped through the gamma curve to 16 bits so brightness scaling keeps
+  the fraction, which dithering then spreads over the next few frames.
+*/
+namespace ColorCorrection {
+  constexpr double LN2 = 0.69314718055994531;
+
+  // Sums 2(z + z^3/3 + z^5/5 ...), which is ln((1 + z) / (1 - z))
+  constexpr double lnSeries(double z, double power, int term) {
+    return term > 24
+             ? 0
+             : power / (2 * term + 1) + lnSeries(z, power * z * z, term + 1);
+  }
+
+  // Halves the range down to [0.5, 1] where the series converges quickly
+  constexpr double ln(double x) {
+    return x < 0.5 ? ln(x * 2) - LN2
+                   : 2 * lnSeries((x - 1) / (x + 1), (x - 1) / (x + 1), 0);
+  }
+
+  constexpr double expSeries(double y, double power, int term) {
+    return term > 16
+             ? 0
+             : power + expSeries(y, power * y / (term + 1), term + 1);
+  }
+
+  constexpr double square(double x) { return x * x; }
+
+  constexpr double exp(double y) {
+    return y < -0.5 ? square(exp(y / 2)) : expSeries(y, 1, 0);
+  }
+
+  constexpr uint16_t gammaLevel(uint8_t level) {
+    return level ? 65535 * exp(LIGHTS_GAMMA * ln(level / 255.0)) + 0.5 : 0;
+  }
+
+  template <uint16_t... levels>
+  struct LevelTable {
+    static constexpr uint16_t values[sizeof...(levels)] = {levels...};
+  };
+
+  template <uint16_t... levels>
+  constexpr uint16_t LevelTable<levels...>::values[];
+
+  template <int count, int... indices>
+  struct GammaTableBuilder
+      : GammaTableBuilder<count - 1, count - 1, indices...> {};
+
+  template <int... indices>
+  struct GammaTableBuilder<0, indices...> {
+    typedef LevelTable<gammaLevel(indices)...> type;
+  };
+
+  typedef GammaTableBuilder<256>::type GammaTable;
+
+  // Rounding thresholds for consecutive frames. They average out to a
+  // half so a dithered level looks like the fraction it stands for.
+  constexpr uint8_t ditherThresholds[8] = {
+    0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0};
+}
+
 struct TriPanelData {
   const int pin;
   const uint16_t numLeds;
@@ -44,47 +250,278 @@ struct TriPanelData {
         startLocation(startLocation) {}
 };
 
+typedef MilliSec (*LightsClock)();
+
 extern MilliSec currentTime;
 
+/*
+  currentTime is read from millis() unless another clock is given, which
+  lets the library run against a virtual clock when it isn't on a board.
+*/
+void setLightsClock(LightsClock clock);
+MilliSec updateCurrentTime();
+
 class TriPanel;
 class PanelSegment;
 class LED;
 
-class LED {
+/*
+  Bump allocator over the LIGHTS_ARENA_SIZE block. Only the most recent
+  block can be given back, which covers the library since its arrays are
+  sized once when the panels are built. Anything that doesn't fit comes
+  from the heap and counts as an overflow. Without LIGHTS_ARENA_SIZE
+  everything comes from the heap and the counters stay at 0.
+*/
+class LightsArena {
+ public:
+  static void* allocate(size_t bytes);
+  static void deallocate(void* block, size_t bytes);
+
+  static size_t capacity();
+  static size_t used();
+  static size_t highWater();
+  static uint32_t overflows();
+};
+
+template <class T>
+struct LightsAllocator {
+  typedef T value_type;
+
+  LightsAllocator() {}
+  template <class U>
+  LightsAllocator(const LightsAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(LightsArena::allocate(count * sizeof(T)));
+  }
+  void deallocate(T* block, size_t count) {
+    LightsArena::deallocate(block, count * sizeof(T));
+  }
+};
+
+template <class T, class U>
+bool operator==(const LightsAllocator<T>&, const LightsAllocator<U>&) {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const LightsAllocator<T>&, const LightsAllocator<U>&) {
+  return false;
+}
+
+// The vector every library array is kept in. In the arena it still
+// copies out to a plain std::vector, so sketches can keep using one.
+#ifdef LIGHTS_ARENA_SIZE
+template <class T>
+class LightsVector : public std::vector<T, LightsAllocator<T>> {
+ public:
+  using std::vector<T, LightsAllocator<T>>::vector;
+
+  operator std::vector<T>() const {
+    return std::vector<T>(this->begin(), this->end());
+  }
+};
+#else
+template <class T>
+using LightsVector = std::vector<T>;
+#endif
+
+/*
+  What a scheduled command does. The panel or hexagon that owns the
+  scheduler runs each one with a switch, and OP_FUNCTION runs a
+  std::function kept aside for work no other op covers.
+*/
+enum CommandOp : uint8_t {
+  OP_FUNCTION,
+  OP_ROTATE,
+  OP_COLOR_SPIN,
+  OP_RAINBOW,
+  OP_COLOR_SHIFT
+};
+
+/*
+  A scheduled command, small enough to copy around the heap freely. A
+  command with repeats left is scheduled again interval after it runs,
+  so a whole spin takes one record instead of one per step.
+*/
+struct EffectCommand {
+  MilliSec runTime;
+  MilliSec interval;
+  uint32_t order;
+  uint16_t repeats;
+  CommandOp op;
+  // Step for OP_ROTATE, speed for OP_COLOR_SPIN and OP_RAINBOW, and the
+  // function's slot for OP_FUNCTION
+  int16_t arg;
+};
+
+/*
+  Min-heap of commands keyed by the time they should run. Commands
+  scheduled for the same time run in the order they were added. Room for
+  LIGHTS_COMMAND_POOL commands and as many functions is set aside up
+  front and reused, so scheduling effects doesn't allocate.
+*/
+class FunctionScheduler {
  private:
-  const uint16_t stripIndex;
-  PanelSegment& mySide;
-  TriPanel& myPanel;
+  LightsVector<EffectCommand> queue;
+  LightsVector<std::function<void()>> functions;
+  LightsVector<int16_t> freeFunctions;
+  uint32_t nextOrder;
+  uint32_t addedCount;
+  size_t peakSize;
+
+  static bool runsAfter(const EffectCommand& a, const EffectCommand& b);
+  void push(EffectCommand command);
 
  public:
-  bool nextColorAvailable;
-  LEDColor currentColor;
-  LEDColor nextColor;
-  MilliSec nextColorChangeTime;
+  FunctionScheduler();
+  ~FunctionScheduler();
+
+  void add(CommandOp op, int16_t arg, MilliSec runTime, uint16_t repeats = 0,
+    MilliSec interval = 0);
+  void add(std::function<void()> fn, MilliSec runTime);
+  bool popDue(MilliSec time, EffectCommand& command);
+  // Moves out the function an OP_FUNCTION command runs and frees its slot
+  std::function<void()> takeFunction(const EffectCommand& command);
+
+  bool empty() const;
+  size_t size() const;
+  void reserve(size_t count);
+  void clear();
+
+  // Counters for profiling how hard effects lean on the scheduler
+  uint32_t functionsAdded() const;
+  size_t peakQueueSize() const;
+  void resetStats();
+};
 
-  static const LEDColor Color(int r, int g, int b);
+/*
+  Keeps count of the LEDs in a panel waiting on a delayed color change
+  and the earliest time one of them is due. The pending colors live in
+  the panel's pixel arrays, so scheduling a change never allocates and
+  rescheduling an LED replaces its old change instead of adding another.
+*/
+class DelayedLEDs {
+ public:
+  static const MilliSec NO_CHANGE = (MilliSec)-1;
 
-  LED(uint16_t index, PanelSegment& ps, TriPanel& p);
-  ~LED();
+  uint16_t count;
+  MilliSec nextChangeTime;
 
-  void resetColor();
+  DelayedLEDs();
+  ~DelayedLEDs();
 
-  void setColor(LEDColor color, MilliSec timeDelay = 0);
+  bool empty() const;
+  void add(MilliSec changeTime);
+  void remove();
+  void clear();
 };
 
+/*
+  Strip positions in a panel written since it was last pushed, kept as
+  one range so any number of writes between frames go out in a single
+  push. A brightness change rescales every pixel, so it dirties the
+  whole strip.
+*/
+class DirtyRange {
+ public:
+  uint16_t first;
+  uint16_t last;
+  bool brightnessChanged;
+
+  DirtyRange();
+  ~DirtyRange();
+
+  bool empty() const;
+  bool pixelsChanged() const;
+  void mark(uint16_t stripIndex);
+  void mark(uint16_t firstIndex, uint16_t lastIndex);
+  void markBrightness();
+  void clear();
+};
+
+/*
+  Progress is a fraction scaled to 0-65535. ease() bends it along the
+  easing curve given and timeProgress() works it out from a time span.
+*/
+uint16_t ease(Easing easing, uint16_t progress);
+uint16_t timeProgress(MilliSec elapsed, MilliSec duration);
+
+/*
+  A brightness that moves from one level to another over time, worked out
+  whenever the panel shows instead of being scheduled a step at a time.
+  When breathing, it rises to its peak, holds for half the fade time,
+  falls back and starts again.
+*/
+class Fade {
+ public:
+  uint8_t from;
+  uint8_t to;
+  MilliSec startTime;
+  MilliSec duration;
+  Easing easing;
+  bool active;
+  bool breathing;
+
+  Fade();
+  ~Fade();
+
+  void start(uint8_t fromBrightness, uint8_t toBrightness,
+    MilliSec fadeDuration, Easing fadeEasing = EASE_LINEAR);
+  void startBreathing(uint8_t maxBrightness, MilliSec fadeDuration,
+    Easing fadeEasing = EASE_LINEAR);
+  void stop();
+
+  uint8_t brightnessAt(MilliSec time);
+};
+
+LEDColor blendColor(LEDColor from, LEDColor to, uint16_t progress);
+
+/*
+  Hues go once round the color wheel over 0-65535, starting at red.
+  rainbowColor() uses whichever of the two LIGHTS_PROCEDURAL_RAINBOW
+  picks.
+*/
+LEDColor rainbowTableColor(uint16_t hue);
+LEDColor rainbowHueColor(uint16_t hue);
+LEDColor rainbowColor(uint16_t hue);
+
+/*
+  A range of a panel's pixels blending from one color to another. Tweens
+  can start after a delay, so queueing several on the same range plays
+  them back to back like keyframes.
+*/
+class ColorTween {
+ public:
+  uint16_t firstPixel;
+  uint16_t lastPixel;
+  LEDColor from;
+  LEDColor to;
+  MilliSec startTime;
+  MilliSec duration;
+  Easing easing;
+
+  LEDColor colorAt(MilliSec time) const;
+  bool started(MilliSec time) const;
+  bool finished(MilliSec time) const;
+};
+
+class LED {
+ public:
+  static const LEDColor Color(int r, int g, int b);
+};
+
+/*
+  A view over the range of a panel's strip indexes that run along one
+  side of the triangle. The pixels themselves are stored by the panel.
+*/
 class PanelSegment {
  private:
   const int numLeds;
-
-  std::vector<LED> leds;
+  uint8_t brightness;
 
   TriPanel& myPanel;
 
-  SideLocation cornersOtherSide(CornerLocation corner);
-
-  template <class Function>
-  void forEachLed(Function fn);
-
  public:
   const int minPixelIndex;
   const int maxPixelIndex;
@@ -98,6 +535,8 @@ class PanelSegment {
 
   void resetPixelColor(uint16_t stripIndex);
 
+  bool fill(Ratio percent, LEDColor color, CornerLocation startLocation,
+    MilliSec duration = 0);
   bool fill(double percent, LEDColor color, CornerLocation startLocation,
     MilliSec duration = 0);
 
@@ -105,6 +544,12 @@ class PanelSegment {
   void setPixelColor(
     uint16_t stripIndex, LEDColor color, MilliSec timeDelay = 0);
   void setColor(LEDColor color, MilliSec timeDelay = 0);
+  bool tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+    Easing easing = EASE_LINEAR, MilliSec timeDelay = 0);
+
+  // Scales this side on top of the panel's brightness
+  uint8_t getBrightness() const;
+  void setBrightness(uint8_t b);
 };
 
 class TriPanel {
@@ -113,111 +558,297 @@ class TriPanel {
   const CornerLocation overallLocation;
   const CornerLocation stripStartLoctation;
 
-  const SideLocation calcFirstSegmentLocation();
-  const SideLocation nextSegmentLocation(SideLocation currentSeg);
-  const SideLocation nextSegmentLocation(
-    SideLocation currentSeg, LoopDirection direction);
-  const SideLocation OppositeSideOfCorner(CornerLocation corner);
+  // Either lights or a strip shared with other panels, which this panel's
+  // pixels start stripOffset pixels into
+  Adafruit_NeoPixel* strip;
+  const uint16_t stripOffset;
 
-  const std::pair<SideLocation, SideLocation> corner2Side(
-    CornerLocation corner);
+  TriPanel(int pin, Adafruit_NeoPixel* sharedStrip, uint16_t offset,
+    uint16_t numLeds, CornerLocation local, LoopDirection spin,
+    CornerLocation startLocation);
 
-  void fadeController(uint8_t brightness, MilliSec& timePassed,
-    MilliSec timeBetweenChange, bool constantColor);
-  void runFunctionLater(std::function<void()> fn, MilliSec timeDelay = 0);
+  void runCommandLater(CommandOp op, int16_t arg, MilliSec timeDelay = 0,
+    uint16_t repeats = 0, MilliSec interval = 0);
 
   void playFunctionSequence();
   void showDelayedLEDs();
+  void showFade();
+  void showTweens();
+
+  void cancelLEDChange(uint16_t stripIndex);
+  void cancelLEDChanges();
+  void writePixelColor(uint16_t stripIndex, LEDColor color);
+  void markAllPixels();
+  void refreshPixels(uint16_t firstIndex, uint16_t lastIndex);
+
+  uint32_t pushedFrames;
+  uint32_t skippedFrames;
+
+  // Applied as pixels are written to the strip, never to currentColors
+  uint8_t brightness;
+  uint8_t masterBrightness;
+  bool gammaCorrection;
+  bool dithering;
+  uint8_t ditherFrame;
 
   template <class Function>
   void forEachSegment(Function fn);
 
  public:
-  bool LEDchanged;
+  // What has to be written to the strip on the next show()
+  DirtyRange dirty;
   CornerLocation cornerAtCenter;
   SideLocation outerSide;
 
-  std::list<std::pair<MilliSec, std::function<void()>>> functionSequence;
-  std::vector<PanelSegment> segments;
-  std::map<SideLocation, int> segSideIndex;
-  std::list<LED*> delayedLEDs;
+  FunctionScheduler functionSequence;
+  Fade fade;
+
+  // Tweens are kept in the order they were added so later ones win
+  // where ranges overlap
+  ColorTween tweens[LIGHTS_MAX_TWEENS];
+  uint8_t tweenCount;
+  LightsVector<PanelSegment> segments;
+  // Segment running along each side. Sides a panel doesn't have map to
+  // the first segment.
+  uint8_t segSideIndex[4];
+  DelayedLEDs delayedLEDs;
+
+  // Pixel state indexed by strip position
+  LightsVector<LEDColor> currentColors;
+  LightsVector<LEDColor> nextColors;
+  LightsVector<MilliSec> nextColorChangeTimes;
 
   Adafruit_NeoPixel lights;
 
   TriPanel(int pin, uint16_t numLeds, CornerLocation local, LoopDirection spin,
     CornerLocation startLocation);
+  // Writes to pixels offset up to offset + numLeds - 1 of sharedStrip,
+  // leaving lights empty
+  TriPanel(Adafruit_NeoPixel& sharedStrip, uint16_t offset, uint16_t numLeds,
+    CornerLocation local, LoopDirection spin, CornerLocation startLocation);
   ~TriPanel();
 
-  static double spinSpeed2Duration(uint8_t speed);
-  void changeLEDLater(LED* led);
+  static MilliSec spinSpeed2Duration(uint8_t speed);
 
+  // constantColor is no longer needed since brightness never touches the
+  // stored colors, and is kept for older sketches
   void breathe(uint8_t maxBrightness = 50, MilliSec fadeDuration = 5000,
-    LEDColor color = 0, bool cc = false);
+    LEDColor color = 0, bool cc = false, Easing easing = EASE_LINEAR);
   void fadeIn(uint8_t maxBrightness = 50, bool constantColor = false,
-    MilliSec duration = 1000);
+    MilliSec duration = 1000, Easing easing = EASE_LINEAR);
   void fadeOut(uint8_t minBrightness = 0, bool constantColor = false,
-    MilliSec duration = 1000);
+    MilliSec duration = 1000, Easing easing = EASE_LINEAR);
 
+  // The double overloads are kept for older sketches and convert to Ratio
+  void fillFromCorner(Ratio percent, LEDColor color, MilliSec duration = 0);
+  void fillFromCorner(Ratio percent, LEDColor color,
+    CornerLocation startLocation, MilliSec duration = 0);
   void fillFromCorner(double percent, LEDColor color, MilliSec duration = 0);
   void fillFromCorner(double percent, LEDColor color,
     CornerLocation startLocation, MilliSec duration = 0);
 
+  void fillToCorner(Ratio percent, LEDColor color, MilliSec duration = 0);
+  void fillToCorner(Ratio percent, LEDColor color,
+    CornerLocation startLocation, MilliSec duration = 0);
   void fillToCorner(double percent, LEDColor color, MilliSec duration = 0);
   void fillToCorner(double percent, LEDColor color,
     CornerLocation startLocation, MilliSec duration = 0);
 
+  void rainbow(Ratio loops, uint8_t speed = 250);
   void rainbow(double loops = 5, uint8_t speed = 250);
   void rainbowTimed(MilliSec duration = 5000, uint8_t speed = 250);
+  // Spreads one turn of the color wheel over the strip. Stepping the
+  // offset each frame moves the rainbow without rotating any pixels.
+  void setRainbow(uint16_t hueOffset = 0);
 
+  void colorSpin(Ratio loops, uint8_t speed = 250);
   void colorSpin(double loops = 5, uint8_t speed = 250);
+  void rotate(int steps = 1);
+
+  bool tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+    Easing easing = EASE_LINEAR, MilliSec timeDelay = 0);
+  bool tweenPixels(uint16_t firstPixel, uint16_t lastPixel, LEDColor from,
+    LEDColor to, MilliSec duration, Easing easing = EASE_LINEAR,
+    MilliSec timeDelay = 0);
+  // Trades colors with another panel, cancelling delayed changes on both
+  // as setting the colors would
+  void swapColors(TriPanel& other);
 
   void resetPixelColor(uint16_t stripIndex);
 
   void clearFunctions();
 
   void begin(uint8_t brightness = 50);
+  // begin() short of pushing the strip, for grids that push each strip
+  // once however many panels share it
+  void setUp(uint8_t brightness = 50);
+  CornerLocation getLocation() const;
   uint8_t getBrightness();
   void setBrightness(uint8_t b);
+  // Scales the panel's brightness, for dimming everything at once
+  uint8_t getMasterBrightness() const;
+  void setMasterBrightness(uint8_t b);
+  // Dithering rewrites the whole panel every frame while it's on
+  void setGammaCorrection(bool enabled);
+  void setDithering(bool enabled);
   void setColor(LEDColor color, MilliSec timeDelay = 0);
-  void setColor(std::vector<LEDColor> colors, MilliSec timeDelay = 0);
-  std::vector<LEDColor> getColor();
+  void setColor(const std::vector<LEDColor>& colors, MilliSec timeDelay = 0);
+  // Takes what getColor() returns, in or out of the arena
+  template <class Allocator>
+  void setColor(
+    const std::vector<LEDColor, Allocator>& colors, MilliSec timeDelay = 0) {
+    setColors(colors.data(), colors.size(), timeDelay);
+  }
+  void setColors(
+    const LEDColor* colors, size_t colorCount, MilliSec timeDelay = 0);
+  const LightsVector<LEDColor>& getColor();
   LEDColor getPixelColor(uint16_t stripIndex);
   void setPixelColor(
     uint16_t stripIndex, LEDColor color, MilliSec timeDelay = 0);
+  // render() runs the effects and writes changes into the strip's buffer,
+  // returning whether the strip needs pushing. show() also pushes it.
+  bool render();
   void show();
+  Adafruit_NeoPixel& getStrip();
+
+  // Counters for tuning how often shows actually reach the strip
+  uint32_t framesPushed() const;
+  uint32_t framesSkipped() const;
+  void resetFrameStats();
 };
 
-class Hexagon {
- private:
-  std::list<std::pair<MilliSec, std::function<void()>>> functionSequence;
+// Two panels in a grid that share a side, by their index in the grid
+struct PanelLink {
+  uint16_t a;
+  uint16_t b;
+};
 
+/*
+  Any number of panels and which of them touch. Effects that spread
+  across the grid go outwards from a panel one link at a time, and
+  colorShift passes colors along the panels in the order they were given.
+*/
+class PanelGrid {
+ private:
+  // Zero when shows aren't held to a frame rate
+  MilliSec frameLength;
+  MilliSec nextFrameTime;
+  uint32_t lateFrameCount;
+  unsigned long maxFrameMicros;
+
+  // Panels built by the grid itself rather than handed to it
+  TriPanel* ownedPanels;
+  uint16_t ownedCount;
+  // Set when every panel is a window onto one strip
+  Adafruit_NeoPixel* sharedStrip;
+
+  // Strips with changes this frame, each pushed once however many panels
+  // it holds
+  LightsVector<Adafruit_NeoPixel*> pendingStrips;
+  uint32_t stripPushCount;
+
+  // Each panel's neighbours are neighborList[neighborStart[panel]] up to
+  // neighborList[neighborStart[panel + 1]]
+  LightsVector<uint16_t> neighborStart;
+  LightsVector<uint16_t> neighborList;
+  LightsVector<uint16_t> hops;
+  LightsVector<uint16_t> searchQueue;
+
+  bool frameDue();
   void playFunctionSequence();
+  void renderPanels();
+  void shiftColors();
+  void measureHops(uint16_t start);
+  void buildPanels(const TriPanelData* panelData, uint16_t panelCount);
 
   template <class Function>
   void forEachPanel(Function fn);
 
- public:
-  std::vector<TriPanel*> panels;
+ protected:
+  PanelGrid();
+  // Sets aside room for every panel before any are added. Growing a panel
+  // at a time would leave each old array behind in the arena.
+  void reservePanels(uint16_t panelCount);
+  void addPanel(TriPanel* panel);
+  void setLinks(const PanelLink* links, size_t linkCount);
 
-  Hexagon();
-  Hexagon(TriPanelData panelData[]);
-  ~Hexagon();
+ public:
+  static const uint16_t NO_PATH = 0xFFFF;
+
+  FunctionScheduler functionSequence;
+  LightsVector<TriPanel*> panels;
+
+  PanelGrid(const TriPanelData* panelData, uint16_t panelCount,
+    const PanelLink* links, size_t linkCount);
+  // All panels chained on one strip on pin, in the order given, so a
+  // frame is a single push. The pins in panelData aren't used.
+  PanelGrid(int pin, const TriPanelData* panelData, uint16_t panelCount,
+    const PanelLink* links, size_t linkCount);
+  PanelGrid(const PanelGrid&) = delete;
+  PanelGrid& operator=(const PanelGrid&) = delete;
+  ~PanelGrid();
+
+  uint16_t neighborCount(uint16_t panel) const;
+  uint16_t neighbor(uint16_t panel, uint16_t which) const;
+  // Links on the shortest path between two panels, NO_PATH if none
+  uint16_t hopsFrom(uint16_t start, uint16_t panel);
+
+  // Each panel starts stepDelay or a hue step after the ones a link
+  // nearer the start panel
+  void fillFromPanel(uint16_t start, LEDColor color, MilliSec stepDelay = 0);
+  void rainbowFromPanel(uint16_t start, uint16_t hueStep);
 
   void breathe(uint8_t maxBrightness = 50, MilliSec fadeDuration = 5000,
-    LEDColor color = 0);
+    LEDColor color = 0, Easing easing = EASE_LINEAR);
 
   void colorShift(MilliSec timeDelay = 0, uint16_t shifts = 1);
 
   void rainbowTimed(MilliSec duration = 5000, uint8_t speed = 250);
+  void rainbow(Ratio loops, uint8_t speed = 250);
   void rainbow(double loops = 5, uint8_t speed = 250);
+  void setRainbow(uint16_t hueOffset = 0);
+
+  void tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+    Easing easing = EASE_LINEAR, MilliSec timeDelay = 0);
 
   void runFunctionLater(std::function<void()> fn, MilliSec timeDelay = 0);
   void clearFunctions();
 
   void begin(uint8_t brightness = 50);
   void setBrightness(uint8_t b);
+  void setMasterBrightness(uint8_t b);
+  void setGammaCorrection(bool enabled);
+  void setDithering(bool enabled);
   void setColor(LEDColor color, MilliSec timeDelay = 0);
+  // With a frame rate set, show() does nothing until the next frame is
+  // due and effects step a whole frame at a time. 0 shows every call.
+  void setFrameRate(uint16_t framesPerSecond);
   void show();
+
+  uint32_t framesPushed();
+  uint32_t framesSkipped();
+  // Frames that started a frame or more behind, and the slowest show()
+  uint32_t lateFrames() const;
+  unsigned long maxFrameTime() const;
+  // Times a strip was written out, which on its own pin costs a latch
+  uint32_t stripPushes() const;
+  void resetFrameStats();
+};
+
+/*
+  Six panels round a hexagon, each linked to the two it shares sides
+  with.
+*/
+class Hexagon : public PanelGrid {
+ private:
+  void linkRing();
+
+ public:
+  Hexagon();
+  Hexagon(TriPanelData panelData[]);
+  // Every panel on one strip on pin, in the order of panelData
+  Hexagon(int pin, TriPanelData panelData[]);
+  ~Hexagon();
 };
 
 static const uint32_t PROGMEM rainbowColors[512] = {0xFF0000, 0xFF0000,
@@ -0,0 +1,60 @@
+#ifndef MILO_LIGHTS_ARENA
+#define MILO_LIGHTS_ARENA
+
+#include "Lights.h"
+
+#include <new>
+
+#ifdef LIGHTS_ARENA_SIZE
+alignas(8) static uint8_t arena[LIGHTS_ARENA_SIZE];
+
+// Blocks are kept 8 byte aligned so any type can start at one
+static size_t blockSize(size_t bytes) { return (bytes + 7) & ~(size_t)7; }
+#endif
+
+static size_t arenaUsed = 0;
+static size_t arenaHighWater = 0;
+static uint32_t arenaOverflows = 0;
+
+void* LightsArena::allocate(size_t bytes) {
+#ifdef LIGHTS_ARENA_SIZE
+  const size_t size = blockSize(bytes);
+  if (size <= LIGHTS_ARENA_SIZE - arenaUsed) {
+    void* block = arena + arenaUsed;
+    arenaUsed += size;
+    arenaHighWater = std::max(arenaHighWater, arenaUsed);
+    return block;
+  }
+  arenaOverflows++;
+#endif
+  return ::operator new(bytes);
+}
+
+void LightsArena::deallocate(void* block, size_t bytes) {
+#ifdef LIGHTS_ARENA_SIZE
+  uint8_t* start = static_cast<uint8_t*>(block);
+  if (start >= arena && start < arena + LIGHTS_ARENA_SIZE) {
+    if (start + blockSize(bytes) == arena + arenaUsed) {
+      arenaUsed = start - arena;
+    }
+    return;
+  }
+#endif
+  ::operator delete(block);
+}
+
+size_t LightsArena::capacity() {
+#ifdef LIGHTS_ARENA_SIZE
+  return LIGHTS_ARENA_SIZE;
+#else
+  return 0;
+#endif
+}
+
+size_t LightsArena::used() { return arenaUsed; }
+
+size_t LightsArena::highWater() { return arenaHighWater; }
+
+uint32_t LightsArena::overflows() { return arenaOverflows; }
+
+#endif  // MILO_LIGHTS_ARENA
@@ -0,0 +1,397 @@
+#ifndef MILO_PANEL_GRID
+#define MILO_PANEL_GRID
+
+#include "Lights.h"
+
+#include <new>
+
+MilliSec currentTime = 0;
+
+static MilliSec arduinoClock() { return millis(); }
+
+static LightsClock lightsClock = arduinoClock;
+
+void setLightsClock(LightsClock clock) {
+  lightsClock = clock ? clock : arduinoClock;
+}
+
+MilliSec updateCurrentTime() { return currentTime = lightsClock(); }
+
+const uint16_t PanelGrid::NO_PATH;
+
+PanelGrid::PanelGrid()
+    : frameLength(0),
+      nextFrameTime(0),
+      lateFrameCount(0),
+      maxFrameMicros(0),
+      ownedPanels(nullptr),
+      ownedCount(0),
+      sharedStrip(nullptr),
+      stripPushCount(0) {}
+
+PanelGrid::PanelGrid(const TriPanelData* panelData, uint16_t panelCount,
+  const PanelLink* links, size_t linkCount)
+    : PanelGrid() {
+  buildPanels(panelData, panelCount);
+  setLinks(links, linkCount);
+}
+
+PanelGrid::PanelGrid(int pin, const TriPanelData* panelData,
+  uint16_t panelCount, const PanelLink* links, size_t linkCount)
+    : PanelGrid() {
+  // No strip for no panels, which is how a rejected layout comes in
+  if (!panelCount) return;
+
+  uint16_t totalLeds = 0;
+  for (uint16_t i = 0; i < panelCount; i++) {
+    totalLeds += panelData[i].numLeds;
+  }
+  sharedStrip = new Adafruit_NeoPixel(totalLeds, pin, NEO_GRB + NEO_KHZ800);
+
+  buildPanels(panelData, panelCount);
+  setLinks(links, linkCount);
+}
+
+PanelGrid::~PanelGrid() {
+  if (ownedPanels) {
+    for (uint16_t i = ownedCount; i; i--) {
+      ownedPanels[i - 1].~TriPanel();
+    }
+    LightsAllocator<TriPanel>().deallocate(ownedPanels, ownedCount);
+  }
+
+  delete sharedStrip;
+}
+
+void PanelGrid::buildPanels(
+  const TriPanelData* panelData, uint16_t panelCount) {
+  // Panels point back into themselves, so they're built in place once
+  // and never moved
+  ownedPanels = LightsAllocator<TriPanel>().allocate(panelCount);
+  ownedCount = panelCount;
+
+  reservePanels(panelCount);
+  uint16_t offset = 0;
+  for (uint16_t i = 0; i < panelCount; i++) {
+    const TriPanelData& pd = panelData[i];
+    if (sharedStrip) {
+      addPanel(new (&ownedPanels[i]) TriPanel(*sharedStrip, offset,
+        pd.numLeds, pd.local, pd.spin, pd.startLocation));
+      offset += pd.numLeds;
+    }
+    else {
+      addPanel(new (&ownedPanels[i])
+          TriPanel(pd.pin, pd.numLeds, pd.local, pd.spin, pd.startLocation));
+    }
+  }
+}
+
+void PanelGrid::reservePanels(uint16_t panelCount) {
+  panels.reserve(panelCount);
+  pendingStrips.reserve(panelCount);
+}
+
+void PanelGrid::addPanel(TriPanel* panel) {
+  panels.push_back(panel);
+}
+
+void PanelGrid::setLinks(const PanelLink* links, size_t linkCount) {
+  const uint16_t panelCount = panels.size();
+
+  // Neighbours are stored packed, with each panel's starting where the
+  // previous panel's end
+  neighborStart.assign(panelCount + 1, 0);
+  for (size_t i = 0; i < linkCount; i++) {
+    if (links[i].a >= panelCount || links[i].b >= panelCount) continue;
+
+    neighborStart[links[i].a + 1]++;
+    neighborStart[links[i].b + 1]++;
+  }
+  for (uint16_t i = 0; i < panelCount; i++) {
+    neighborStart[i + 1] += neighborStart[i];
+  }
+
+  hops.assign(panelCount, NO_PATH);
+  searchQueue.assign(neighborStart.begin(), neighborStart.end() - 1);
+
+  // The search queue isn't needed yet, so it tracks where each panel's
+  // next neighbour goes
+  neighborList.assign(neighborStart[panelCount], 0);
+  for (size_t i = 0; i < linkCount; i++) {
+    if (links[i].a >= panelCount || links[i].b >= panelCount) continue;
+
+    neighborList[searchQueue[links[i].a]++] = links[i].b;
+    neighborList[searchQueue[links[i].b]++] = links[i].a;
+  }
+}
+
+uint16_t PanelGrid::neighborCount(uint16_t panel) const {
+  if ((size_t)panel + 1 >= neighborStart.size()) return 0;
+
+  return neighborStart[panel + 1] - neighborStart[panel];
+}
+
+uint16_t PanelGrid::neighbor(uint16_t panel, uint16_t which) const {
+  if (which >= neighborCount(panel)) return NO_PATH;
+
+  return neighborList[neighborStart[panel] + which];
+}
+
+void PanelGrid::measureHops(uint16_t start) {
+  std::fill(hops.begin(), hops.end(), NO_PATH);
+  if (start >= hops.size()) return;
+
+  // Breadth first, so every panel is reached by its shortest path
+  uint16_t head = 0;
+  uint16_t tail = 0;
+  hops[start] = 0;
+  searchQueue[tail++] = start;
+
+  while (head < tail) {
+    const uint16_t panel = searchQueue[head++];
+    for (uint16_t i = 0; i < neighborCount(panel); i++) {
+      const uint16_t next = neighbor(panel, i);
+      if (hops[next] == NO_PATH) {
+        hops[next] = hops[panel] + 1;
+        searchQueue[tail++] = next;
+      }
+    }
+  }
+}
+
+uint16_t PanelGrid::hopsFrom(uint16_t start, uint16_t panel) {
+  measureHops(start);
+  return panel < hops.size() ? hops[panel] : NO_PATH;
+}
+
+void PanelGrid::fillFromPanel(
+  uint16_t start, LEDColor color, MilliSec stepDelay) {
+  measureHops(start);
+  for (uint16_t i = 0; i < hops.size(); i++) {
+    if (hops[i] != NO_PATH) {
+      panels[i]->setColor(color, hops[i] * stepDelay);
+    }
+  }
+}
+
+void PanelGrid::rainbowFromPanel(uint16_t start, uint16_t hueStep) {
+  measureHops(start);
+  for (uint16_t i = 0; i < hops.size(); i++) {
+    if (hops[i] != NO_PATH) {
+      panels[i]->setRainbow(hops[i] * hueStep);
+    }
+  }
+}
+
+void PanelGrid::playFunctionSequence() {
+  EffectCommand command;
+  while (functionSequence.popDue(currentTime, command)) {
+    switch (command.op) {
+      case OP_COLOR_SHIFT:
+        shiftColors();
+        break;
+      default: {
+        std::function<void()> fn = functionSequence.takeFunction(command);
+        if (fn) {
+          fn();
+        }
+        break;
+      }
+    }
+  }
+}
+
+template <class Function>
+void PanelGrid::forEachPanel(Function fn) {
+  for (TriPanel* panel : panels) {
+    fn(panel);
+  }
+}
+
+void PanelGrid::breathe(uint8_t maxBrightness, MilliSec fadeDuration,
+  LEDColor color, Easing easing) {
+  forEachPanel([=](TriPanel* panel) {
+    panel->breathe(maxBrightness, fadeDuration, color, false, easing);
+  });
+}
+
+void PanelGrid::shiftColors() {
+  if (panels.size() < 2) return;
+
+  bool sameLength = true;
+  for (TriPanel* panel : panels) {
+    sameLength = sameLength &&
+      panel->getColor().size() == panels[0]->getColor().size();
+  }
+
+  if (sameLength) {
+    for (size_t i = panels.size(); i > 1; i--) {
+      panels[i - 1]->swapColors(*panels[i - 2]);
+    }
+    return;
+  }
+
+  // Swapping would stretch colors more than once on their way round, so
+  // each panel takes the colors of the one before it directly
+  const LightsVector<LEDColor> lastColors = panels.back()->getColor();
+  for (size_t i = panels.size() - 1; i; i--) {
+    const LightsVector<LEDColor>& colors = panels[i - 1]->getColor();
+    panels[i]->setColors(colors.data(), colors.size());
+  }
+  panels[0]->setColors(lastColors.data(), lastColors.size());
+}
+
+void PanelGrid::colorShift(MilliSec timeDelay, uint16_t shifts) {
+  if (!shifts) return;
+
+  functionSequence.add(
+    OP_COLOR_SHIFT, 0, currentTime + timeDelay, shifts - 1, timeDelay);
+}
+
+void PanelGrid::rainbowTimed(MilliSec duration, uint8_t speed) {
+  forEachPanel([=](TriPanel* panel) { panel->rainbowTimed(duration, speed); });
+}
+
+void PanelGrid::rainbow(Ratio loops, uint8_t speed) {
+  forEachPanel([=](TriPanel* panel) { panel->rainbow(loops, speed); });
+}
+
+void PanelGrid::rainbow(double loops, uint8_t speed) {
+  rainbow(Ratio::fromDouble(loops), speed);
+}
+
+void PanelGrid::setRainbow(uint16_t hueOffset) {
+  forEachPanel([hueOffset](TriPanel* panel) { panel->setRainbow(hueOffset); });
+}
+
+void PanelGrid::tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+  Easing easing, MilliSec timeDelay) {
+  forEachPanel([=](TriPanel* panel) {
+    panel->tweenColor(from, to, duration, easing, timeDelay);
+  });
+}
+
+void PanelGrid::runFunctionLater(std::function<void()> fn, MilliSec timeDelay) {
+  functionSequence.add(fn, currentTime + timeDelay);
+}
+
+void PanelGrid::clearFunctions() {
+  forEachPanel([](TriPanel* panel) { panel->clearFunctions(); });
+  functionSequence.clear();
+}
+
+void PanelGrid::begin(uint8_t brightness) {
+  updateCurrentTime();
+  forEachPanel([brightness](TriPanel* panel) { panel->setUp(brightness); });
+  renderPanels();
+  setColor(LED::Color(0, 0, 0));
+}
+
+void PanelGrid::setBrightness(uint8_t b) {
+  forEachPanel([b](TriPanel* panel) { panel->setBrightness(b); });
+}
+
+void PanelGrid::setMasterBrightness(uint8_t b) {
+  forEachPanel([b](TriPanel* panel) { panel->setMasterBrightness(b); });
+}
+
+void PanelGrid::setGammaCorrection(bool enabled) {
+  forEachPanel(
+    [enabled](TriPanel* panel) { panel->setGammaCorrection(enabled); });
+}
+
+void PanelGrid::setDithering(bool enabled) {
+  forEachPanel([enabled](TriPanel* panel) { panel->setDithering(enabled); });
+}
+
+void PanelGrid::setColor(LEDColor color, MilliSec timeDelay) {
+  forEachPanel([=](TriPanel* panel) { panel->setColor(color, timeDelay); });
+}
+
+void PanelGrid::setFrameRate(uint16_t framesPerSecond) {
+  frameLength = framesPerSecond ? 1000 / framesPerSecond : 0;
+  if (frameLength) {
+    nextFrameTime = lightsClock();
+  }
+}
+
+bool PanelGrid::frameDue() {
+  const MilliSec now = lightsClock();
+  if (now < nextFrameTime) return false;
+
+  // Frames that can't be made up are dropped rather than run back to back
+  const MilliSec behind = now - nextFrameTime;
+  if (behind >= frameLength) {
+    lateFrameCount++;
+    nextFrameTime += behind / frameLength * frameLength;
+  }
+
+  // Effects see the time the frame was due, not when it got to run, so
+  // they move the same amount every frame. Time set since, by begin() or
+  // updateCurrentTime(), can be later and is never gone back on, since
+  // effects started then would see it run backwards.
+  currentTime = std::max(currentTime, nextFrameTime);
+  nextFrameTime += frameLength;
+  return true;
+}
+
+void PanelGrid::show() {
+  if (frameLength && !frameDue()) return;
+
+  const unsigned long start = micros();
+  playFunctionSequence();
+  renderPanels();
+
+  maxFrameMicros = std::max(maxFrameMicros, micros() - start);
+
+  if (!frameLength) {
+    updateCurrentTime();
+  }
+}
+
+void PanelGrid::renderPanels() {
+  // Panels sharing a strip write into its buffer first so it only goes
+  // out once
+  pendingStrips.clear();
+  for (TriPanel* panel : panels) {
+    if (!panel->render()) continue;
+
+    Adafruit_NeoPixel* strip = &panel->getStrip();
+    if (std::find(pendingStrips.begin(), pendingStrips.end(), strip) ==
+        pendingStrips.end()) {
+      pendingStrips.push_back(strip);
+    }
+  }
+  for (Adafruit_NeoPixel* strip : pendingStrips) {
+    strip->show();
+  }
+  stripPushCount += pendingStrips.size();
+}
+
+uint32_t PanelGrid::framesPushed() {
+  uint32_t pushed = 0;
+  forEachPanel([&pushed](TriPanel* panel) { pushed += panel->framesPushed(); });
+  return pushed;
+}
+
+uint32_t PanelGrid::framesSkipped() {
+  uint32_t skipped = 0;
+  forEachPanel(
+    [&skipped](TriPanel* panel) { skipped += panel->framesSkipped(); });
+  return skipped;
+}
+
+uint32_t PanelGrid::lateFrames() const { return lateFrameCount; }
+
+unsigned long PanelGrid::maxFrameTime() const { return maxFrameMicros; }
+
+uint32_t PanelGrid::stripPushes() const { return stripPushCount; }
+
+void PanelGrid::resetFrameStats() {
+  forEachPanel([](TriPanel* panel) { panel->resetFrameStats(); });
+  lateFrameCount = 0;
+  maxFrameMicros = 0;
+  stripPushCount = 0;
+}
+
+#endif  // MILO_PANEL_GRID
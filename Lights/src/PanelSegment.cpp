@@ -4,76 +4,74 @@
 #include "Lights.h"
 
 PanelSegment::PanelSegment(SideLocation s, int min, int max, TriPanel& p)
-    : side(s),
+    : numLeds(max - min + 1),
+      brightness(255),
+      myPanel(p),
       minPixelIndex(min),
       maxPixelIndex(max),
-      numLeds(max - min + 1),
-      myPanel(p) {
-  for (size_t i = minPixelIndex; i <= maxPixelIndex; i++) {
-    leds.push_back(LED(i, *this, myPanel));
-  }
-}
+      side(s) {}
 
 PanelSegment::~PanelSegment() {}
 
-SideLocation PanelSegment::cornersOtherSide(CornerLocation corner) {
-  switch (corner) {
-    case CL_LT:
-      return side == SL_LEFT ? SL_TOP : SL_LEFT;
-    case CL_RT:
-      return side == SL_RIGHT ? SL_TOP : SL_RIGHT;
-    case CL_LB:
-      return side == SL_LEFT ? SL_BOTTOM : SL_LEFT;
-    case CL_RB:
-      return side == SL_RIGHT ? SL_BOTTOM : SL_RIGHT;
-    default:
-      return side == SL_LEFT ? SL_RIGHT : SL_LEFT;
-  }
-}
-
-template <class Function>
-void PanelSegment::forEachLed(Function fn) {
-  for (LED& led : leds) {
-    fn(led);
-  }
-}
-
 void PanelSegment::resetPixelColor(uint16_t stripIndex) {
   if (stripIndex >= minPixelIndex && stripIndex <= maxPixelIndex) {
-    leds[stripIndex - minPixelIndex].resetColor();
+    myPanel.resetPixelColor(stripIndex);
   }
 }
 
-bool PanelSegment::fill(double percent, LEDColor color,
+bool PanelSegment::fill(Ratio percent, LEDColor color,
   CornerLocation startLocation, MilliSec duration) {
-  const SideLocation opposingSide = cornersOtherSide(startLocation);
-  const bool loopBack = (nextSegLocation == opposingSide) == (percent > 0);
-  const int pixels2Fill = round(numLeds * fabs(percent));
+  const SideLocation opposingSide =
+    PanelGeometry::otherCornerSide(startLocation, side);
+  const bool loopBack = (nextSegLocation == opposingSide) == (percent.q16 > 0);
+  const int pixels2Fill = abs(percent.of(numLeds));
   const int timeBetweenLed = pixels2Fill ? duration / pixels2Fill : 0;
 
-  const int firstLed = loopBack ? numLeds - 1 : 0;
+  const int firstLed = loopBack ? maxPixelIndex : minPixelIndex;
   const int incr = loopBack ? -1 : 1;
 
-  for (size_t i = 0; i < pixels2Fill; i++) {
-    leds[firstLed + i * incr].setColor(color, timeBetweenLed * i);
+  for (int i = 0; i < pixels2Fill; i++) {
+    myPanel.setPixelColor(firstLed + i * incr, color, timeBetweenLed * i);
   }
 
   return pixels2Fill == numLeds;
 }
 
+bool PanelSegment::fill(double percent, LEDColor color,
+  CornerLocation startLocation, MilliSec duration) {
+  return fill(Ratio::fromDouble(percent), color, startLocation, duration);
+}
+
 LEDColor PanelSegment::getPixelColor(uint16_t stripIndex) {
-  return leds[stripIndex - minPixelIndex].currentColor;
+  return myPanel.getPixelColor(stripIndex);
 }
 
 void PanelSegment::setPixelColor(
   uint16_t stripIndex, LEDColor color, MilliSec timeDelay) {
   if (stripIndex >= minPixelIndex && stripIndex <= maxPixelIndex) {
-    leds[stripIndex - minPixelIndex].setColor(color, timeDelay);
+    myPanel.setPixelColor(stripIndex, color, timeDelay);
   }
 }
 
 void PanelSegment::setColor(LEDColor color, MilliSec timeDelay) {
-  forEachLed([=](LED& led) { led.setColor(color, timeDelay); });
+  for (int i = minPixelIndex; i <= maxPixelIndex; i++) {
+    myPanel.setPixelColor(i, color, timeDelay);
+  }
+}
+
+bool PanelSegment::tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+  Easing easing, MilliSec timeDelay) {
+  return myPanel.tweenPixels(
+    minPixelIndex, maxPixelIndex, from, to, duration, easing, timeDelay);
+}
+
+uint8_t PanelSegment::getBrightness() const { return brightness; }
+
+void PanelSegment::setBrightness(uint8_t b) {
+  if (b == brightness) return;
+
+  brightness = b;
+  myPanel.dirty.mark(minPixelIndex, maxPixelIndex);
 }
 
 #endif  // MILO_PANEL_SEGMENT
@@ -0,0 +1,47 @@
+#ifndef MILO_RAINBOW
+#define MILO_RAINBOW
+
+#include "Lights.h"
+
+LEDColor rainbowTableColor(uint16_t hue) {
+  return pgm_read_dword(&rainbowColors[hue >> 7]);
+}
+
+/*
+  Full saturation HSV in integers. The wheel is six sectors where one
+  channel is full, one is off and the third ramps, and the ramp goes
+  through the gamma table so the blends look like the hand-built table.
+*/
+LEDColor rainbowHueColor(uint16_t hue) {
+  const uint32_t position = (uint32_t)hue * 6;
+  const uint8_t sector = position >> 16;
+  const uint8_t step = (position >> 8) & 0xFF;
+
+  const uint8_t rising = ColorCorrection::GammaTable::values[step] >> 8;
+  const uint8_t falling = ColorCorrection::GammaTable::values[255 - step] >> 8;
+
+  switch (sector) {
+    case 0:
+      return LED::Color(255, rising, 0);
+    case 1:
+      return LED::Color(falling, 255, 0);
+    case 2:
+      return LED::Color(0, 255, rising);
+    case 3:
+      return LED::Color(0, falling, 255);
+    case 4:
+      return LED::Color(rising, 0, 255);
+    default:
+      return LED::Color(255, 0, falling);
+  }
+}
+
+LEDColor rainbowColor(uint16_t hue) {
+#if LIGHTS_PROCEDURAL_RAINBOW
+  return rainbowHueColor(hue);
+#else
+  return rainbowTableColor(hue);
+#endif
+}
+
+#endif  // MILO_RAINBOW
@@ -3,215 +3,235 @@
 
 #include "Lights.h"
 
+// Brightness levels multiply, with 255 leaving the other level as it is
+static uint8_t scaleBrightness(uint8_t level, uint8_t scale) {
+  return (level * (scale + 1)) >> 8;
+}
+
+static LEDColor scaleColor(LEDColor color, uint8_t brightness) {
+  const uint16_t scale = brightness + 1;
+  const uint8_t r = (((color >> 16) & 0xFF) * scale) >> 8;
+  const uint8_t g = (((color >> 8) & 0xFF) * scale) >> 8;
+  const uint8_t b = ((color & 0xFF) * scale) >> 8;
+  return ((LEDColor)r << 16) | ((LEDColor)g << 8) | b;
+}
+
+// Scales a level at 16 bits and rounds it back down against threshold
+static uint8_t correctLevel(
+  uint8_t level, uint16_t scale, bool gamma, uint8_t threshold) {
+  const uint32_t linear =
+    gamma ? ColorCorrection::GammaTable::values[level] : level * 257;
+  const uint32_t scaled = ((linear * scale) >> 8) + threshold;
+  return std::min<uint32_t>(scaled >> 8, 255);
+}
+
+static LEDColor correctColor(
+  LEDColor color, uint8_t brightness, bool gamma, uint8_t threshold) {
+  const uint16_t scale = brightness + 1;
+  const uint8_t r = correctLevel((color >> 16) & 0xFF, scale, gamma, threshold);
+  const uint8_t g = correctLevel((color >> 8) & 0xFF, scale, gamma, threshold);
+  const uint8_t b = correctLevel(color & 0xFF, scale, gamma, threshold);
+  return ((LEDColor)r << 16) | ((LEDColor)g << 8) | b;
+}
+
 TriPanel::TriPanel(int pin, uint16_t numLeds, CornerLocation local,
   LoopDirection spin, CornerLocation start)
-    : overallLocation(local),
-      lightDirection(spin),
+    : TriPanel(pin, nullptr, 0, numLeds, local, spin, start) {}
+
+TriPanel::TriPanel(Adafruit_NeoPixel& sharedStrip, uint16_t offset,
+  uint16_t numLeds, CornerLocation local, LoopDirection spin,
+  CornerLocation start)
+    : TriPanel(-1, &sharedStrip, offset, numLeds, local, spin, start) {}
+
+TriPanel::TriPanel(int pin, Adafruit_NeoPixel* sharedStrip, uint16_t offset,
+  uint16_t numLeds, CornerLocation local, LoopDirection spin,
+  CornerLocation start)
+    : lightDirection(spin),
+      overallLocation(local),
       stripStartLoctation(start),
-      lights(Adafruit_NeoPixel(numLeds, pin, NEO_GRB + NEO_KHZ800)),
-      LEDchanged(true) {
-  const int corner1 = (numLeds - 2) / 3;
-  const int corner2 = corner1 * 2 + 1;
-
-  SideLocation segment1Location = calcFirstSegmentLocation();
-  SideLocation segment2Location = nextSegmentLocation(segment1Location);
-  SideLocation segment3Location = nextSegmentLocation(segment2Location);
-
-  PanelSegment segment1(segment1Location, 0, corner1, *this);
-  PanelSegment segment2(segment2Location, corner1 + 1, corner2, *this);
-  PanelSegment segment3(segment3Location, corner2 + 1, numLeds - 1, *this);
-
-  segment1.nextSegLocation = segment3.prevSegLocation = segment2Location;
-  segment2.nextSegLocation = segment1.prevSegLocation = segment3Location;
-  segment3.nextSegLocation = segment2.prevSegLocation = segment1Location;
-
-  segments.push_back(segment1);
-  segments.push_back(segment2);
-  segments.push_back(segment3);
-
-  segSideIndex[segment1Location] = 0;
-  segSideIndex[segment2Location] = 1;
-  segSideIndex[segment3Location] = 2;
-
-  switch (local) {
-    case CL_MT:
-      cornerAtCenter = CL_MB;
-      break;
-    case CL_MB:
-      cornerAtCenter = CL_MT;
-      break;
-    case CL_LT:
-      cornerAtCenter = CL_RB;
-      break;
-    case CL_LB:
-      cornerAtCenter = CL_RT;
-      break;
-    case CL_RT:
-      cornerAtCenter = CL_LB;
-      break;
-    case CL_RB:
-      cornerAtCenter = CL_LT;
-      break;
+      strip(sharedStrip ? sharedStrip : &lights),
+      stripOffset(offset),
+      pushedFrames(0),
+      skippedFrames(0),
+      brightness(255),
+      masterBrightness(255),
+      gammaCorrection(false),
+      dithering(false),
+      ditherFrame(0),
+      tweenCount(0),
+      currentColors(numLeds, 0),
+      nextColors(numLeds, 0),
+      nextColorChangeTimes(numLeds, DelayedLEDs::NO_CHANGE),
+      lights(Adafruit_NeoPixel(
+        sharedStrip ? 0 : numLeds, pin, NEO_GRB + NEO_KHZ800)) {
+  using namespace PanelGeometry;
+
+  SideLocation segmentLocations[3];
+  for (int i = 0; i < 3; i++) {
+    segmentLocations[i] = segmentSide(local, spin, start, i);
   }
 
-  outerSide = OppositeSideOfCorner(cornerAtCenter);
-}
+  std::fill(segSideIndex, segSideIndex + 4, 0);
 
-TriPanel::~TriPanel() {}
+  segments.reserve(3);
+
+  for (int i = 0; i < 3; i++) {
+    const uint16_t lastPixel =
+      i < 2 ? segmentStart(numLeds, i + 1) - 1 : numLeds - 1;
+    PanelSegment segment(
+      segmentLocations[i], segmentStart(numLeds, i), lastPixel, *this);
 
-const SideLocation TriPanel::calcFirstSegmentLocation() {
-  switch (stripStartLoctation) {
-    case CL_MT:
-      return lightDirection == CW ? SL_RIGHT : SL_LEFT;
-    case CL_MB:
-      return lightDirection == CW ? SL_LEFT : SL_RIGHT;
-    case CL_LT:
-      return lightDirection == CW ? SL_TOP : SL_LEFT;
-    case CL_LB:
-      return lightDirection == CW ? SL_LEFT : SL_BOTTOM;
-    case CL_RT:
-      return lightDirection == CW ? SL_RIGHT : SL_TOP;
-    case CL_RB:
-      return lightDirection == CW ? SL_BOTTOM : SL_RIGHT;
+    segment.nextSegLocation = segmentLocations[(i + 1) % 3];
+    segment.prevSegLocation = segmentLocations[(i + 2) % 3];
+
+    segments.push_back(segment);
+    segSideIndex[segmentLocations[i]] = i;
   }
+
+  cornerAtCenter = oppositeCorner(local);
+  outerSide = oppositeSide(cornerAtCenter);
+
+  markAllPixels();
 }
 
-const SideLocation TriPanel::nextSegmentLocation(SideLocation currentSeg) {
-  return nextSegmentLocation(currentSeg, lightDirection);
+TriPanel::~TriPanel() {}
+
+void TriPanel::runCommandLater(CommandOp op, int16_t arg,
+  MilliSec timeDelay, uint16_t repeats, MilliSec interval) {
+  functionSequence.add(op, arg, currentTime + timeDelay, repeats, interval);
 }
 
-const SideLocation TriPanel::nextSegmentLocation(
-  SideLocation currentSeg, LoopDirection direction) {
-  switch (overallLocation) {
-    case CL_MT:
-    case CL_LB:
-    case CL_RB:
-      switch (currentSeg) {
-        case SL_TOP:
-          return direction == CW ? SL_RIGHT : SL_LEFT;
-        case SL_RIGHT:
-          return direction == CW ? SL_LEFT : SL_TOP;
-        case SL_LEFT:
-          return direction == CW ? SL_TOP : SL_RIGHT;
-      }
-    case CL_MB:
-    case CL_LT:
-    case CL_RT:
-      switch (currentSeg) {
-        case SL_RIGHT:
-          return direction == CW ? SL_BOTTOM : SL_LEFT;
-        case SL_BOTTOM:
-          return direction == CW ? SL_LEFT : SL_RIGHT;
-        case SL_LEFT:
-          return direction == CW ? SL_RIGHT : SL_BOTTOM;
+void TriPanel::playFunctionSequence() {
+  EffectCommand command;
+  while (functionSequence.popDue(currentTime, command)) {
+    switch (command.op) {
+      case OP_ROTATE:
+        rotate(command.arg);
+        break;
+      case OP_COLOR_SPIN:
+        colorSpin(Ratio(0), command.arg);
+        break;
+      case OP_RAINBOW:
+        rainbow(Ratio(0), command.arg);
+        break;
+      default: {
+        std::function<void()> fn = functionSequence.takeFunction(command);
+        if (fn) {
+          fn();
+        }
+        break;
       }
+    }
   }
 }
 
-const SideLocation TriPanel::OppositeSideOfCorner(CornerLocation corner) {
-  switch (corner) {
-    case CL_MT:
-      return SL_BOTTOM;
-    case CL_MB:
-      return SL_TOP;
-    case CL_LT:
-    case CL_LB:
-      return SL_RIGHT;
-    default:
-      return SL_LEFT;
+void TriPanel::showDelayedLEDs() {
+  if (delayedLEDs.nextChangeTime >= currentTime) return;
+
+  MilliSec nextChangeTime = DelayedLEDs::NO_CHANGE;
+  for (size_t i = 0; i < nextColorChangeTimes.size(); i++) {
+    const MilliSec changeTime = nextColorChangeTimes[i];
+    if (changeTime == DelayedLEDs::NO_CHANGE) continue;
+
+    if (changeTime < currentTime) {
+      setPixelColor(i, nextColors[i]);
+    }
+    else if (changeTime < nextChangeTime) {
+      nextChangeTime = changeTime;
+    }
   }
+  delayedLEDs.nextChangeTime = nextChangeTime;
 }
 
-const std::pair<SideLocation, SideLocation> TriPanel::corner2Side(
-  CornerLocation corner) {
-  SideLocation vertical;
-  SideLocation horizontal;
-
-  switch (corner) {
-    case CL_MT:
-    case CL_MB:
-      return {SL_LEFT, SL_RIGHT};
-    case CL_LT:
-    case CL_RT:
-      vertical = SL_TOP;
-      break;
-    default:
-      vertical = SL_BOTTOM;
-      break;
+void TriPanel::cancelLEDChange(uint16_t stripIndex) {
+  if (nextColorChangeTimes[stripIndex] != DelayedLEDs::NO_CHANGE) {
+    nextColorChangeTimes[stripIndex] = DelayedLEDs::NO_CHANGE;
+    delayedLEDs.remove();
   }
+}
 
-  switch (corner) {
-    case CL_LT:
-    case CL_LB:
-      horizontal = SL_LEFT;
-      break;
-    case CL_RT:
-    case CL_RB:
-      horizontal = SL_RIGHT;
-      break;
-  }
+void TriPanel::cancelLEDChanges() {
+  std::fill(nextColorChangeTimes.begin(), nextColorChangeTimes.end(),
+    DelayedLEDs::NO_CHANGE);
+  delayedLEDs.clear();
+}
+
+void TriPanel::writePixelColor(uint16_t stripIndex, LEDColor color) {
+  // Writing the color a pixel already has doesn't need a push
+  if (currentColors[stripIndex] == color) return;
 
-  return {vertical, horizontal};
+  currentColors[stripIndex] = color;
+  dirty.mark(stripIndex);
 }
 
-void TriPanel::fadeController(uint8_t brightness, MilliSec& timePassed,
-  MilliSec timeBetweenChange, bool constantColor) {
-  runFunctionLater(
-    [this, brightness, constantColor]() {
-      setBrightness(brightness);
-      if (constantColor) {
-        for (size_t i = 0; i < lights.numPixels(); i++) {
-          resetPixelColor(i);
-        }
-      }
-    },
-    timePassed += timeBetweenChange);
+void TriPanel::markAllPixels() {
+  if (currentColors.empty()) return;
+
+  dirty.mark(0, currentColors.size() - 1);
 }
 
-void TriPanel::runFunctionLater(std::function<void()> fn, MilliSec timeDelay) {
-  timeDelay += currentTime;
-  if (functionSequence.empty()) {
-    functionSequence.push_back({timeDelay, fn});
-    return;
-  }
+void TriPanel::refreshPixels(uint16_t firstIndex, uint16_t lastIndex) {
+  const uint8_t panelBrightness = scaleBrightness(masterBrightness, brightness);
+
+  // Each side works out its scale once, then the pixels only multiply
+  for (PanelSegment& segment : segments) {
+    const uint8_t scale =
+      scaleBrightness(panelBrightness, segment.getBrightness());
+    const int first = std::max<int>(firstIndex, segment.minPixelIndex);
+    const int last = std::min<int>(lastIndex, segment.maxPixelIndex);
+
+    if (!gammaCorrection && !dithering) {
+      for (int i = first; i <= last; i++) {
+        strip->setPixelColor(
+          stripOffset + i, scaleColor(currentColors[i], scale));
+      }
+      continue;
+    }
 
-  for (auto it = functionSequence.begin(); it != functionSequence.end(); ++it) {
-    if (it->first >= timeDelay) {
-      functionSequence.insert(it, {timeDelay, fn});
-      return;
+    // Neighbouring pixels start at different points in the threshold
+    // cycle so a dithered panel doesn't flicker all at once
+    for (int i = first; i <= last; i++) {
+      const uint8_t threshold = dithering
+        ? ColorCorrection::ditherThresholds[(ditherFrame + i) & 7]
+        : 0x80;
+      strip->setPixelColor(stripOffset + i,
+        correctColor(currentColors[i], scale, gammaCorrection, threshold));
     }
   }
-
-  functionSequence.push_back({timeDelay, fn});
 }
 
-void TriPanel::playFunctionSequence() {
-  while (!functionSequence.empty()) {
-    const MilliSec waitTime = functionSequence.front().first;
-    const std::function<void()> fn = functionSequence.front().second;
-    const bool timesUp = waitTime < currentTime;
-    if (timesUp) {
-      functionSequence.pop_front();
-      fn();
-    }
-    else if (!timesUp) {
-      return;
-    }
+void TriPanel::showFade() {
+  if (!fade.active) return;
+
+  const uint8_t fadeBrightness = fade.brightnessAt(currentTime);
+  if (fadeBrightness != brightness) {
+    brightness = fadeBrightness;
+    dirty.markBrightness();
   }
 }
 
-void TriPanel::showDelayedLEDs() {
-  while (!delayedLEDs.empty()) {
-    LED* led = delayedLEDs.front();
-    const bool timesUp = led->nextColorChangeTime < currentTime;
-    if (led->nextColorAvailable && timesUp) {
-      delayedLEDs.pop_front();
-      led->setColor(led->nextColor);
+void TriPanel::showTweens() {
+  uint8_t kept = 0;
+
+  for (uint8_t i = 0; i < tweenCount; i++) {
+    const ColorTween& tween = tweens[i];
+    if (tween.started(currentTime)) {
+      const LEDColor color = tween.colorAt(currentTime);
+      for (uint16_t p = tween.firstPixel; p <= tween.lastPixel; p++) {
+        cancelLEDChange(p);
+        writePixelColor(p, color);
+      }
+
+      if (tween.finished(currentTime)) continue;
     }
-    else if (!timesUp) {
-      break;
+
+    if (kept != i) {
+      tweens[kept] = tween;
     }
+    kept++;
   }
+
+  tweenCount = kept;
 }
 
 template <class Function>
@@ -221,91 +241,60 @@ void TriPanel::forEachSegment(Function fn) {
   }
 }
 
-double TriPanel::spinSpeed2Duration(uint8_t speed) {
-  return 256 * round(500 * (1 - speed / 256.0));
+MilliSec TriPanel::spinSpeed2Duration(uint8_t speed) {
+  // 500 * (1 - speed / 256) rounded to the nearest whole
+  return 256 * ((500 * (256 - speed) + 128) >> 8);
 }
 
-void TriPanel::changeLEDLater(LED* led) {
-  if (delayedLEDs.empty()) {
-    delayedLEDs.push_front(led);
-    return;
-  }
-
-  for (auto it = delayedLEDs.begin(); it != delayedLEDs.end(); ++it) {
-    if ((*it)->nextColorChangeTime >= led->nextColorChangeTime) {
-      delayedLEDs.insert(it, led);
-      return;
-    }
-  }
-
-  delayedLEDs.push_back(led);
-}
-
-void TriPanel::breathe(
-  uint8_t maxBrightness, MilliSec fadeDuration, LEDColor color, bool cc) {
-  bool constantColor = cc || (delayedLEDs.empty() && functionSequence.empty());
+void TriPanel::breathe(uint8_t maxBrightness, MilliSec fadeDuration,
+  LEDColor color, bool cc, Easing easing) {
   if (color) {
     setColor(color);
-    constantColor = true;
   }
-  setBrightness(0);
-
-  fadeIn(maxBrightness, constantColor, fadeDuration);
 
-  runFunctionLater(
-    [this, fadeDuration, constantColor]() {
-      fadeOut(0, constantColor, fadeDuration);
-    },
-    fadeDuration * 1.5);
-  runFunctionLater(
-    [this, color, maxBrightness, fadeDuration, constantColor]() {
-      breathe(maxBrightness, fadeDuration, color, constantColor);
-    },
-    fadeDuration * 2.5);
+  setBrightness(0);
+  fade.startBreathing(maxBrightness, fadeDuration, easing);
 }
 
-void TriPanel::fadeIn(
-  uint8_t maxBrightness, bool constantColor, MilliSec duration) {
+void TriPanel::fadeIn(uint8_t maxBrightness, bool constantColor,
+  MilliSec duration, Easing easing) {
   const uint8_t currentBrightness = getBrightness();
   if (currentBrightness >= maxBrightness) return;
 
-  const MilliSec timeBetweenChange =
-    (double)duration / (maxBrightness - currentBrightness);
-
-  MilliSec timePassed = 0;
-  for (size_t b = currentBrightness; b <= maxBrightness; b++) {
-    fadeController(b, timePassed, timeBetweenChange, constantColor);
-  }
+  fade.start(currentBrightness, maxBrightness, duration, easing);
 }
 
-void TriPanel::fadeOut(
-  uint8_t minBrightness, bool constantColor, MilliSec duration) {
+void TriPanel::fadeOut(uint8_t minBrightness, bool constantColor,
+  MilliSec duration, Easing easing) {
   const uint8_t currentBrightness = getBrightness();
   if (currentBrightness <= minBrightness) return;
 
-  const MilliSec timeBetweenChange =
-    (double)duration / (currentBrightness - minBrightness);
+  fade.start(currentBrightness, minBrightness, duration, easing);
+}
 
-  MilliSec timePassed = 0;
-  for (int b = currentBrightness; b >= minBrightness; b--) {
-    fadeController(b, timePassed, timeBetweenChange, constantColor);
-  }
+void TriPanel::fillFromCorner(
+  Ratio percent, LEDColor color, MilliSec duration) {
+  fillFromCorner(percent, color, cornerAtCenter, duration);
 }
 
 void TriPanel::fillFromCorner(
   double percent, LEDColor color, MilliSec duration) {
-  fillFromCorner(percent, color, cornerAtCenter, duration);
+  fillFromCorner(Ratio::fromDouble(percent), color, cornerAtCenter, duration);
 }
 
 void TriPanel::fillFromCorner(
   double percent, LEDColor color, CornerLocation start, MilliSec duration) {
-  std::pair<SideLocation, SideLocation> sidesUsed = corner2Side(start);
+  fillFromCorner(Ratio::fromDouble(percent), color, start, duration);
+}
 
-  PanelSegment& segment1 = segments[segSideIndex[sidesUsed.first]];
-  PanelSegment& segment2 = segments[segSideIndex[sidesUsed.second]];
+void TriPanel::fillFromCorner(
+  Ratio percent, LEDColor color, CornerLocation start, MilliSec duration) {
+  using namespace PanelGeometry;
+
+  PanelSegment& segment1 = segments[segSideIndex[cornerSide(start, 0)]];
+  PanelSegment& segment2 = segments[segSideIndex[cornerSide(start, 1)]];
 
-  PanelSegment& capSegment =
-    segments[segSideIndex[OppositeSideOfCorner(start)]];
+  PanelSegment& capSegment = segments[segSideIndex[oppositeSide(start)]];
 
   bool allLightsOn1 = segment1.fill(percent, color, start, duration);
   bool allLightsOn2 = segment2.fill(percent, color, start, duration);
@@ -315,19 +304,27 @@ void TriPanel::fillFromCorner(
   }
 }
 
-void TriPanel::fillToCorner(double percent, LEDColor color, MilliSec duration) {
+void TriPanel::fillToCorner(Ratio percent, LEDColor color, MilliSec duration) {
   fillToCorner(percent, color, cornerAtCenter, duration);
 }
 
+void TriPanel::fillToCorner(double percent, LEDColor color, MilliSec duration) {
+  fillToCorner(Ratio::fromDouble(percent), color, cornerAtCenter, duration);
+}
+
 void TriPanel::fillToCorner(
   double percent, LEDColor color, CornerLocation start, MilliSec duration) {
-  std::pair<SideLocation, SideLocation> sidesUsed = corner2Side(start);
+  fillToCorner(Ratio::fromDouble(percent), color, start, duration);
+}
 
-  PanelSegment& segment1 = segments[segSideIndex[sidesUsed.first]];
-  PanelSegment& segment2 = segments[segSideIndex[sidesUsed.second]];
+void TriPanel::fillToCorner(
+  Ratio percent, LEDColor color, CornerLocation start, MilliSec duration) {
+  using namespace PanelGeometry;
 
-  PanelSegment& capSegment =
-    segments[segSideIndex[OppositeSideOfCorner(start)]];
+  PanelSegment& segment1 = segments[segSideIndex[cornerSide(start, 0)]];
+  PanelSegment& segment2 = segments[segSideIndex[cornerSide(start, 1)]];
+
+  PanelSegment& capSegment = segments[segSideIndex[oppositeSide(start)]];
 
   capSegment.setColor(color);
 
@@ -335,134 +332,283 @@ void TriPanel::fillToCorner(
   segment2.fill(-percent, color, start, duration);
 }
 
-void TriPanel::rainbow(double loops, uint8_t speed) {
-  if (!loops) {
-    rainbow(1, speed);
-    runFunctionLater(
-      [this, speed]() { rainbow(0, speed); }, spinSpeed2Duration(speed));
-  }
-
-  const int pixelCount = lights.numPixels();
-  const double colorsToSkip = 512.0 / pixelCount;
-
-  for (size_t i = 0; i < pixelCount; i++) {
-    setPixelColor(i,
-      pgm_read_dword(&rainbowColors[(int)(i * colorsToSkip) % 512]));
+void TriPanel::rainbow(Ratio loops, uint8_t speed) {
+  if (!loops.q16) {
+    rainbow(Ratio(Ratio::ONE), speed);
+    runCommandLater(OP_RAINBOW, speed, spinSpeed2Duration(speed));
+    return;
   }
 
+  setRainbow();
   colorSpin(loops, speed);
 }
 
+void TriPanel::rainbow(double loops, uint8_t speed) {
+  rainbow(Ratio::fromDouble(loops), speed);
+}
+
 void TriPanel::rainbowTimed(MilliSec duration, uint8_t speed) {
-  rainbow(duration / spinSpeed2Duration(speed), speed);
+  rainbow(Ratio(((uint64_t)duration << 16) / spinSpeed2Duration(speed)), speed);
 }
 
-void TriPanel::colorSpin(double loops, uint8_t speed) {
-  if (!loops) {
-    colorSpin(1, speed);
-    runFunctionLater(
-      [this, speed]() { colorSpin(0, speed); }, spinSpeed2Duration(speed));
+void TriPanel::setRainbow(uint16_t hueOffset) {
+  const uint32_t pixelCount = currentColors.size();
+
+  for (uint32_t i = 0; i < pixelCount; i++) {
+    setPixelColor(i, rainbowColor(hueOffset + (i << 16) / pixelCount));
+  }
+}
+
+void TriPanel::colorSpin(Ratio loops, uint8_t speed) {
+  if (!loops.q16) {
+    colorSpin(Ratio(Ratio::ONE), speed);
+    runCommandLater(OP_COLOR_SPIN, speed, spinSpeed2Duration(speed));
     return;
   }
 
-  const int pixelCount = lights.numPixels();
+  const int pixelCount = currentColors.size();
   const int functionDelay = spinSpeed2Duration(speed) / pixelCount;
-  const int incr = pixelCount + (lightDirection == CW ? -1 : 1);
-
-  for (size_t currentPixel = 0; currentPixel < pixelCount * loops;
-       currentPixel++) {
-    auto fn = [this, currentPixel, pixelCount, incr]() {
-      LEDColor prevColors[pixelCount];
-      for (size_t i = 0; i < pixelCount; i++) {
-        prevColors[i] = getPixelColor(i);
-      }
+  const int step = lightDirection == CW ? 1 : -1;
+  // One step for every pixel in the loops, counting a part pixel as one.
+  // Parts smaller than the ratio's rounding error don't count.
+  const uint32_t steps = loops.q16 > 0
+    ? ((uint64_t)pixelCount * loops.q16 + Ratio::ONE - 1 - pixelCount / 2) >> 16
+    : 0;
+
+  // Each command repeats itself for up to 65536 steps
+  for (uint32_t firstStep = 0; firstStep < steps; firstStep += 0x10000) {
+    const uint32_t count = std::min<uint32_t>(steps - firstStep, 0x10000);
+    runCommandLater(
+      OP_ROTATE, step, firstStep * functionDelay, count - 1, functionDelay);
+  }
+}
 
-      for (size_t i = 0; i < pixelCount; i++) {
-        setPixelColor(i, prevColors[(i + incr) % pixelCount]);
-      }
-    };
+void TriPanel::colorSpin(double loops, uint8_t speed) {
+  colorSpin(Ratio::fromDouble(loops), speed);
+}
+
+void TriPanel::rotate(int steps) {
+  const int pixelCount = currentColors.size();
+  if (!pixelCount) return;
+
+  // Positive steps move each color towards the end of the strip
+  const int shift = ((steps % pixelCount) + pixelCount) % pixelCount;
+  if (!shift) return;
+
+  std::rotate(currentColors.begin(), currentColors.end() - shift,
+    currentColors.end());
+  markAllPixels();
+}
+
+bool TriPanel::tweenColor(LEDColor from, LEDColor to, MilliSec duration,
+  Easing easing, MilliSec timeDelay) {
+  return tweenPixels(
+    0, currentColors.size() - 1, from, to, duration, easing, timeDelay);
+}
+
+bool TriPanel::tweenPixels(uint16_t firstPixel, uint16_t lastPixel,
+  LEDColor from, LEDColor to, MilliSec duration, Easing easing,
+  MilliSec timeDelay) {
+  if (tweenCount >= LIGHTS_MAX_TWEENS || firstPixel > lastPixel ||
+      lastPixel >= currentColors.size()) {
+    return false;
+  }
 
-    runFunctionLater(fn, currentPixel * functionDelay);
+  ColorTween& tween = tweens[tweenCount++];
+  tween.firstPixel = firstPixel;
+  tween.lastPixel = lastPixel;
+  tween.from = from;
+  tween.to = to;
+  tween.startTime = currentTime + timeDelay;
+  tween.duration = duration;
+  tween.easing = easing;
+  return true;
+}
+
+void TriPanel::swapColors(TriPanel& other) {
+  if (currentColors.size() != other.currentColors.size()) {
+    const LightsVector<LEDColor> myColors = currentColors;
+    setColors(other.currentColors.data(), other.currentColors.size());
+    other.setColors(myColors.data(), myColors.size());
+    return;
   }
+
+  cancelLEDChanges();
+  other.cancelLEDChanges();
+  currentColors.swap(other.currentColors);
+  markAllPixels();
+  other.markAllPixels();
 }
 
 void TriPanel::resetPixelColor(uint16_t stripIndex) {
-  for (PanelSegment& segment : segments) {
-    if (segment.minPixelIndex <= stripIndex &&
-        segment.maxPixelIndex >= stripIndex) {
-      segment.resetPixelColor(stripIndex);
-      return;
-    }
-  }
+  if (stripIndex >= currentColors.size()) return;
+
+  dirty.mark(stripIndex);
 }
 
 void TriPanel::clearFunctions() {
   functionSequence.clear();
-  delayedLEDs.clear();
+  fade.stop();
+  tweenCount = 0;
+  cancelLEDChanges();
 }
 
 void TriPanel::begin(uint8_t brightness) {
-  lights.begin();
-  lights.clear();
-  setBrightness(brightness);
+  setUp(brightness);
   show();
 }
 
-uint8_t TriPanel::getBrightness() { return lights.getBrightness(); }
+void TriPanel::setUp(uint8_t brightness) {
+  strip->begin();
+  if (strip == &lights) {
+    lights.clear();
+  }
+  markAllPixels();
+  setBrightness(brightness);
+}
+
+CornerLocation TriPanel::getLocation() const { return overallLocation; }
+
+uint8_t TriPanel::getBrightness() { return brightness; }
 
 void TriPanel::setBrightness(uint8_t b) {
-  lights.setBrightness(b);
-  LEDchanged = true;
+  fade.stop();
+  if (b == brightness) return;
+
+  brightness = b;
+  dirty.markBrightness();
 }
 
-void TriPanel::setColor(LEDColor color, MilliSec timeDelay) {
-  forEachSegment(
-    [=](PanelSegment& segment) { segment.setColor(color, timeDelay); });
+uint8_t TriPanel::getMasterBrightness() const { return masterBrightness; }
+
+void TriPanel::setMasterBrightness(uint8_t b) {
+  if (b == masterBrightness) return;
+
+  masterBrightness = b;
+  dirty.markBrightness();
 }
 
-void TriPanel::setColor(std::vector<LEDColor> colors, MilliSec timeDelay) {
-  const double incr = (double)colors.size() / lights.numPixels();
-  for (size_t i = 0; i < lights.numPixels(); i++) {
-    setPixelColor(i, colors[i * incr], timeDelay);
-  }
+void TriPanel::setGammaCorrection(bool enabled) {
+  if (enabled == gammaCorrection) return;
+
+  gammaCorrection = enabled;
+  markAllPixels();
+}
+
+void TriPanel::setDithering(bool enabled) {
+  if (enabled == dithering) return;
+
+  dithering = enabled;
+  markAllPixels();
 }
 
-std::vector<LEDColor> TriPanel::getColor() {
-  std::vector<LEDColor> colors(lights.numPixels());
-  for (size_t i = 0; i < lights.numPixels(); i++) {
-    colors[i] = getPixelColor(i);
+void TriPanel::setColor(LEDColor color, MilliSec timeDelay) {
+  if (timeDelay) {
+    for (size_t i = 0; i < currentColors.size(); i++) {
+      setPixelColor(i, color, timeDelay);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < currentColors.size(); i++) {
+    cancelLEDChange(i);
+    writePixelColor(i, color);
   }
-  return colors;
 }
 
-LEDColor TriPanel::getPixelColor(uint16_t stripIndex) {
-  for (PanelSegment& segment : segments) {
-    if (segment.minPixelIndex <= stripIndex &&
-        segment.maxPixelIndex >= stripIndex) {
-      return segment.getPixelColor(stripIndex);
+void TriPanel::setColor(
+  const std::vector<LEDColor>& colors, MilliSec timeDelay) {
+  setColors(colors.data(), colors.size(), timeDelay);
+}
+
+void TriPanel::setColors(
+  const LEDColor* colors, size_t colorCount, MilliSec timeDelay) {
+  const size_t pixelCount = currentColors.size();
+  if (!colorCount) return;
+
+  // Stretches or squeezes the colors given to cover the whole panel
+  if (timeDelay) {
+    for (size_t i = 0; i < pixelCount; i++) {
+      setPixelColor(i, colors[i * colorCount / pixelCount], timeDelay);
     }
+    return;
+  }
+
+  for (size_t i = 0; i < pixelCount; i++) {
+    cancelLEDChange(i);
+    writePixelColor(i, colors[i * colorCount / pixelCount]);
   }
 }
 
+const LightsVector<LEDColor>& TriPanel::getColor() { return currentColors; }
+
+LEDColor TriPanel::getPixelColor(uint16_t stripIndex) {
+  if (stripIndex >= currentColors.size()) return 0;
+
+  return currentColors[stripIndex];
+}
+
 void TriPanel::setPixelColor(
   uint16_t stripIndex, LEDColor color, MilliSec timeDelay) {
-  for (PanelSegment& segment : segments) {
-    if (segment.minPixelIndex <= stripIndex &&
-        segment.maxPixelIndex >= stripIndex) {
-      segment.setPixelColor(stripIndex, color, timeDelay);
-      return;
-    }
+  if (stripIndex >= currentColors.size()) return;
+
+  cancelLEDChange(stripIndex);
+
+  if (timeDelay) {
+    nextColors[stripIndex] = color;
+    nextColorChangeTimes[stripIndex] = currentTime + timeDelay;
+    delayedLEDs.add(currentTime + timeDelay);
+  }
+  else {
+    writePixelColor(stripIndex, color);
   }
 }
 
-void TriPanel::show() {
+bool TriPanel::render() {
   playFunctionSequence();
   showDelayedLEDs();
+  showTweens();
+  showFade();
 
-  if (LEDchanged) {
-    lights.show();
-    LEDchanged = false;
+  if (dithering) {
+    ditherFrame++;
+    markAllPixels();
+  }
+
+  if (dirty.empty()) {
+    skippedFrames++;
+    return false;
+  }
+
+  // Every write since the last frame goes out in the next push. A new
+  // brightness changes the scale of every pixel, so all are rewritten.
+  if (dirty.brightnessChanged) {
+    refreshPixels(0, currentColors.size() - 1);
+  }
+  else {
+    refreshPixels(dirty.first, dirty.last);
   }
+
+  dirty.clear();
+  pushedFrames++;
+  return true;
+}
+
+void TriPanel::show() {
+  if (render()) {
+    strip->show();
+  }
+}
+
+Adafruit_NeoPixel& TriPanel::getStrip() { return *strip; }
+
+uint32_t TriPanel::framesPushed() const { return pushedFrames; }
+
+uint32_t TriPanel::framesSkipped() const { return skippedFrames; }
+
+void TriPanel::resetFrameStats() {
+  pushedFrames = 0;
+  skippedFrames = 0;
 }
 
 #endif  // MILO_LIGHT_TRI_PANEL